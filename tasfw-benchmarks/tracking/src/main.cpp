@@ -0,0 +1,173 @@
+// Compares the LibSm64 dirty-page tracking and savestate backends, and the
+// fork server.
+// Every configuration plays the same m64, saving at a fixed interval, then
+// loads random saves and plays a few frames after each.
+//
+// Usage: tracking-benchmark <libsm64> <m64> [frames]
+
+#include <tasfw/resources/LibSm64.hpp>
+#include <tasfw/resources/LibSm64ForkServer.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+
+constexpr int SAVE_INTERVAL = 15; // typical scattershot segment length
+constexpr int FRAMES_AFTER_LOAD = 15;
+constexpr int N_LOADS = 2000;
+
+class BenchmarkCase
+{
+public:
+	const char* name;
+	LibSm64Tracking tracking;
+	bool incrementalSaves;
+	bool forkServer = false;
+	LibSm64Savestates savestates = LibSm64Savestates::PAGE_COPY;
+};
+
+static double microseconds(std::chrono::steady_clock::duration duration)
+{
+	return std::chrono::duration<double, std::micro>(duration).count();
+}
+
+template <class TResource>
+static void advance(TResource& resource, M64& m64, int64_t frame)
+{
+	const Inputs* m64Inputs = m64.frames.Find(frame);
+	Inputs inputs = m64Inputs ? *m64Inputs : Inputs();
+	uint8_t* pads = resource.template getSymbol<uint8_t>(GameSymbol::gControllerPads);
+	memcpy(pads, &inputs.buttons, sizeof(uint16_t));
+	pads[2] = static_cast<uint8_t>(inputs.stick_x);
+	pads[3] = static_cast<uint8_t>(inputs.stick_y);
+
+	resource.template FrameAdvance<TResource>();
+}
+
+template <class TResource>
+static void measure(const BenchmarkCase& benchmarkCase, TResource& resource, M64& m64, int64_t nFrames)
+{
+	using clock = std::chrono::steady_clock;
+
+	std::vector<std::pair<int64_t, int64_t>> saves; // slot, frame
+	clock::duration advanceTime {}, saveTime {}, loadTime {};
+	uint64_t nAdvances = 0;
+
+	for (int64_t frame = 0; frame < nFrames; frame++)
+	{
+		auto start = clock::now();
+		advance(resource, m64, resource.getCurrentFrame());
+		advanceTime += clock::now() - start;
+		nAdvances++;
+
+		if (frame % SAVE_INTERVAL == 0)
+		{
+			start = clock::now();
+			int64_t slotId = resource.SaveState();
+			saveTime += clock::now() - start;
+			saves.emplace_back(slotId, resource.getCurrentFrame());
+		}
+	}
+
+	uint64_t savedBytes = resource.slotManager._currentSaveMem;
+	size_t nSaves = saves.size();
+
+	std::mt19937 rng(0);
+	uint64_t nLoads = 0;
+	for (int i = 0; i < N_LOADS; i++)
+	{
+		auto [slotId, frame] = saves[rng() % saves.size()];
+		if (!resource.slotManager.PrepareLoad(slotId))
+			continue;
+
+		auto start = clock::now();
+		resource.LoadState(slotId);
+		loadTime += clock::now() - start;
+		nLoads++;
+
+		for (int j = 0; j < FRAMES_AFTER_LOAD; j++)
+		{
+			start = clock::now();
+			advance(resource, m64, resource.getCurrentFrame());
+			advanceTime += clock::now() - start;
+			nAdvances++;
+		}
+	}
+
+	printf("%-28s %12.2f %12.2f %12.2f %14.1f\n", benchmarkCase.name,
+		microseconds(advanceTime) / nAdvances,
+		microseconds(saveTime) / nSaves,
+		nLoads ? microseconds(loadTime) / nLoads : 0.0,
+		double(savedBytes) / nSaves / 1024);
+	fflush(stdout);
+}
+
+static void run(const BenchmarkCase& benchmarkCase, const std::filesystem::path& dllPath, M64& m64, int64_t nFrames)
+{
+	if (benchmarkCase.forkServer)
+	{
+		LibSm64ForkServerConfig config;
+		config.dllPath = dllPath;
+		config.countryCode = CountryCode::SUPER_MARIO_64_J;
+
+		LibSm64ForkServer resource(config);
+		measure(benchmarkCase, resource, m64, nFrames);
+		return;
+	}
+
+	LibSm64Config config;
+	config.dllPath = dllPath;
+	config.countryCode = CountryCode::SUPER_MARIO_64_J;
+	config.lightweight = false;
+	config.incrementalSaves = benchmarkCase.incrementalSaves;
+	config.tracking = benchmarkCase.tracking;
+	config.savestates = benchmarkCase.savestates;
+
+	LibSm64 resource(config);
+	measure(benchmarkCase, resource, m64, nFrames);
+}
+
+int main(int argc, const char* argv[])
+{
+	if (argc < 3)
+	{
+		fprintf(stderr, "Usage: %s <libsm64> <m64> [frames]\n", argv[0]);
+		return 1;
+	}
+
+	std::filesystem::path dllPath = argv[1];
+	M64 m64 = M64(argv[2]);
+	m64.load();
+	int64_t nFrames = argc >= 4 ? std::stoll(argv[3]) : 3000;
+
+	const BenchmarkCase cases[] = {
+		{"write-fault", LibSm64Tracking::WRITE_FAULT, false},
+		{"write-fault, incremental", LibSm64Tracking::WRITE_FAULT, true},
+		{"soft-dirty", LibSm64Tracking::SOFT_DIRTY, false},
+		{"soft-dirty, incremental", LibSm64Tracking::SOFT_DIRTY, true},
+		{"memfd remap", LibSm64Tracking::WRITE_FAULT, false, false, LibSm64Savestates::MEMFD_REMAP},
+		{"page dedup", LibSm64Tracking::WRITE_FAULT, false, false, LibSm64Savestates::PAGE_DEDUP},
+		{"fork server", LibSm64Tracking::WRITE_FAULT, false, true},
+	};
+
+	printf("%-28s %12s %12s %12s %14s\n", "tracking", "advance (us)", "save (us)", "load (us)", "KiB per save");
+	fflush(stdout);
+
+	// Every resource loads its own copy of the library and routes its own write
+	// faults, so the cases can run one after another in this process
+	for (const BenchmarkCase& benchmarkCase : cases)
+	{
+		try
+		{
+			run(benchmarkCase, dllPath, m64, nFrames);
+		}
+		catch (const std::exception& e)
+		{
+			printf("%-28s %s\n", benchmarkCase.name, e.what());
+			fflush(stdout);
+		}
+	}
+
+	return 0;
+}
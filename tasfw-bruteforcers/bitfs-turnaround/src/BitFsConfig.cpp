@@ -42,8 +42,9 @@ const std::filesystem::path& getPathToSelf()
 }
 #endif
 
+// Paths may not exist yet, e.g. a cache directory that is created on first use
 static std::filesystem::path resolvePathwithSelf(const std::filesystem::path& path) {
-	return std::filesystem::canonical(getPathToSelf().parent_path() / path);
+	return std::filesystem::weakly_canonical(getPathToSelf().parent_path() / path);
 }
 
 BitFs_ConfigData BitFs_ConfigData::load(const std::filesystem::path& path)
@@ -72,5 +73,11 @@ BitFs_ConfigData BitFs_ConfigData::load(const std::filesystem::path& path)
 	// Additional entries may be added
 	return BitFs_ConfigData {
 		.libSM64 = resolvePathwithSelf(json.at("libsm64").get<std::string>()),
-		.m64File = resolvePathwithSelf(json.at("m64_file").get<std::string>())};
+		.m64File = resolvePathwithSelf(json.at("m64_file").get<std::string>()),
+		.saveSpillDir = json.contains("save_spill_dir") ?
+			resolvePathwithSelf(json.at("save_spill_dir").get<std::string>()) : std::filesystem::path(),
+		.saveCacheDir = json.contains("save_cache_dir") ?
+			resolvePathwithSelf(json.at("save_cache_dir").get<std::string>()) : std::filesystem::path(),
+		.saveMemoryBudget = json.contains("save_memory_budget_mb") ?
+			json.at("save_memory_budget_mb").get<int64_t>() * 1024 * 1024 : 0};
 }
\ No newline at end of file
@@ -1,3 +1,4 @@
+#include <cstdint>
 #include <filesystem>
 
 const std::filesystem::path& getPathToSelf();
@@ -5,6 +6,9 @@ const std::filesystem::path& getPathToSelf();
 struct BitFs_ConfigData {
 	std::filesystem::path libSM64;
 	std::filesystem::path m64File;
+	std::filesystem::path saveSpillDir; // optional, empty if not configured
+	std::filesystem::path saveCacheDir; // optional, created if missing
+	int64_t saveMemoryBudget = 0; // optional, bytes for all threads' savestates
 	
 	// add extra config details here...
 	
@@ -61,8 +61,8 @@ public:
     {
         return ModifyAdhoc([&]()
             {
-                MarioState* marioState = *(MarioState**)(resource->addr("gMarioState"));
-                Camera* camera = *(Camera**)(resource->addr("gCamera"));
+                MarioState* marioState = *resource->getSymbol<MarioState*>(GameSymbol::gMarioState);
+                Camera* camera = *resource->getSymbol<Camera*>(GameSymbol::gCamera);
 
                 // Scripts
                 if (CheckMovementOptions(MovementOption::REWIND))
@@ -100,10 +100,10 @@ public:
 
     SShotState_BitfsDr GetStateBin()
     {
-        MarioState* marioState = *(MarioState**)(resource->addr("gMarioState"));
-        Camera* camera = *(Camera**)(resource->addr("gCamera"));
-        const BehaviorScript* pyramidmBehavior = (const BehaviorScript*)(resource->addr("bhvLllTiltingInvertedPyramid"));
-        Object* objectPool = (Object*)(resource->addr("gObjectPool"));
+        MarioState* marioState = *resource->getSymbol<MarioState*>(GameSymbol::gMarioState);
+        Camera* camera = *resource->getSymbol<Camera*>(GameSymbol::gCamera);
+        const BehaviorScript* pyramidmBehavior = resource->getSymbol<const BehaviorScript>(GameSymbol::bhvLllTiltingInvertedPyramid);
+        Object* objectPool = resource->getSymbol<Object>(GameSymbol::gObjectPool);
         Object* pyramid = &objectPool[84];
         //if (pyramid->behavior != pyramidmBehavior)
 
@@ -186,10 +186,10 @@ public:
 
     bool ValidateState()
     {
-        MarioState* marioState = *(MarioState**)(resource->addr("gMarioState"));
-        Camera* camera = *(Camera**)(resource->addr("gCamera"));
-        const BehaviorScript* pyramidmBehavior = (const BehaviorScript*)(resource->addr("bhvLllTiltingInvertedPyramid"));
-        Object* objectPool = (Object*)(resource->addr("gObjectPool"));
+        MarioState* marioState = *resource->getSymbol<MarioState*>(GameSymbol::gMarioState);
+        Camera* camera = *resource->getSymbol<Camera*>(GameSymbol::gCamera);
+        const BehaviorScript* pyramidmBehavior = resource->getSymbol<const BehaviorScript>(GameSymbol::bhvLllTiltingInvertedPyramid);
+        Object* objectPool = resource->getSymbol<Object>(GameSymbol::gObjectPool);
         Object* pyramid = &objectPool[84];
 
         if (marioState->pos[0] < -2330 || marioState->pos[0] > -1550)
@@ -258,7 +258,7 @@ public:
 
     float GetStateFitness()
     {
-        Object* objectPool = (Object*)(resource->addr("gObjectPool"));
+        Object* objectPool = resource->getSymbol<Object>(GameSymbol::gObjectPool);
         Object* pyramid = &objectPool[84];
 
         return pyramid->oTiltingPyramidNormalY;
@@ -269,8 +269,8 @@ private:
     {
         return ModifyAdhoc([&]()
             {
-                MarioState* marioState = *(MarioState**)(resource->addr("gMarioState"));
-                Camera* camera = *(Camera**)(resource->addr("gCamera"));
+                MarioState* marioState = *resource->getSymbol<MarioState*>(GameSymbol::gMarioState);
+                Camera* camera = *resource->getSymbol<Camera*>(GameSymbol::gCamera);
 
                 // Validate consitions for dive
                 if (marioState->action != ACT_WALKING || marioState->forwardVel < 29.0f)
@@ -295,9 +295,9 @@ private:
     {
         return ModifyAdhoc([&]()
             {
-                MarioState* marioState = *(MarioState**)(resource->addr("gMarioState"));
-                Camera* camera = *(Camera**)(resource->addr("gCamera"));
-                Object* objectPool = (Object*)(resource->addr("gObjectPool"));
+                MarioState* marioState = *resource->getSymbol<MarioState*>(GameSymbol::gMarioState);
+                Camera* camera = *resource->getSymbol<Camera*>(GameSymbol::gCamera);
+                Object* objectPool = resource->getSymbol<Object>(GameSymbol::gObjectPool);
                 Object* pyramid = &objectPool[84];
 
                 // Turn 2048 towrds uphill
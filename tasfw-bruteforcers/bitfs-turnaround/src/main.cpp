@@ -50,8 +50,8 @@ public:
 		//trackPlatform->oPosX = -1945.0f;
 		//AdvanceFrameRead();
 		//Save();
-		Camera* camera = *(Camera**)(resource->addr("gCamera"));
-		MarioState* marioState = *(MarioState**)(resource->addr("gMarioState"));
+		Camera* camera = *resource->getSymbol<Camera*>(GameSymbol::gCamera);
+		MarioState* marioState = *resource->getSymbol<MarioState*>(GameSymbol::gMarioState);
 		auto stick = Inputs::GetClosestInputByYawExact(-16384, 32, camera->yaw);
 		AdvanceFrameWrite(Inputs(0, stick.first, stick.second));
 
@@ -67,10 +67,7 @@ public:
 	{
 		// Save m64Diff to M64
 		M64Diff diff = GetBaseDiff();
-		for (auto& [frame, inputs]: diff.frames)
-		{
-			_m64->frames[frame] = inputs;
-		}
+		_m64->frames.Merge(diff.frames);
 
 		return true;
 	}
@@ -85,7 +82,7 @@ void InitConfiguration(Configuration& configuration)
 	configuration.MaxHashes = 10 * configuration.MaxBlocks;
 	configuration.MaxSharedBlocks = 20000000;
 	configuration.MaxSharedHashes = 10 * configuration.MaxSharedBlocks;
-	configuration.TotalThreads = 3;
+	configuration.TotalThreads = omp_get_num_procs();
 	configuration.MaxSharedSegments = 25000000;
 	configuration.MaxLocalSegments = 2000000;
 	configuration.MaxLightningLength = 10000;
@@ -98,10 +95,7 @@ void InitConfiguration(Configuration& configuration)
 
 	configuration.SetResourcePaths(std::vector<std::string>
 		{
-			"C:\\Users\\Tyler\\Documents\\repos\\sm64_tas_scripting\\res\\sm64_jp_0.dll",
-			"C:\\Users\\Tyler\\Documents\\repos\\sm64_tas_scripting\\res\\sm64_jp_1.dll",
-			"C:\\Users\\Tyler\\Documents\\repos\\sm64_tas_scripting\\res\\sm64_jp_2.dll",
-			"C:\\Users\\Tyler\\Documents\\repos\\sm64_tas_scripting\\res\\sm64_jp_3.dll"
+			"C:\\Users\\Tyler\\Documents\\repos\\sm64_tas_scripting\\res\\sm64_jp.dll"
 		});
 }
 
@@ -118,6 +112,7 @@ int main(int argc, const char* argv[])
 
 	Configuration config;
 	InitConfiguration(config);
+	config.SaveMemoryBudget = cfg.saveMemoryBudget;
 
 	//M64 m64 = M64(config.M64Path);
 	//m64.load();
@@ -128,6 +123,8 @@ int main(int argc, const char* argv[])
 			resourceConfig.dllPath = path;
 			resourceConfig.lightweight = true;
 			resourceConfig.countryCode = CountryCode::SUPER_MARIO_64_J;
+			resourceConfig.saveSpillDirectory = cfg.saveSpillDir;
+			resourceConfig.saveCacheDirectory = cfg.saveCacheDir;
 
 			return resourceConfig;
 		});
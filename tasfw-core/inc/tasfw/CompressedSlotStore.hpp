@@ -0,0 +1,89 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#ifndef COMPRESSEDSLOTSTORE_H
+#define COMPRESSEDSLOTSTORE_H
+
+// Second savestate tier. Serialized slots are split into pages; zero pages are
+// elided, identical pages are shared between entries, and the rest are LZ
+// compressed. The store never drops entries on its own: the owner checks
+// IsOverBudget() and erases GetOldestKey() until it fits again.
+class CompressedSlotStore
+{
+public:
+	static constexpr size_t PAGE_SIZE = 4096;
+
+	class Stats
+	{
+	public:
+		uint64_t nEntries = 0;
+		uint64_t rawBytes = 0; // serialized size of all entries
+		uint64_t storedBytes = 0; // bytes charged against the budget
+		uint64_t nStoredPages = 0; // distinct compressed pages held
+		uint64_t nZeroPages = 0; // pages elided because they were all zero
+		uint64_t nDuplicatePages = 0; // pages elided because an identical page was already stored
+		uint64_t nInserts = 0;
+		uint64_t nReads = 0;
+		uint64_t compressTime = 0;
+		uint64_t decompressTime = 0;
+	};
+
+	int64_t memLimit;
+
+	CompressedSlotStore(int64_t memLimit) : memLimit(memLimit) { }
+
+	void Insert(int32_t key, std::span<const uint8_t> data);
+	bool Contains(int32_t key) const;
+	void Read(int32_t key, std::vector<uint8_t>& out);
+	void Erase(int32_t key);
+
+	bool IsOverBudget() const { return static_cast<int64_t>(_stats.storedBytes) > memLimit; }
+	int32_t GetOldestKey() const { return _lruHead; }
+	const Stats& GetStats() const { return _stats; }
+
+private:
+	static constexpr uint32_t ZERO_PAGE = UINT32_MAX;
+
+	class Page
+	{
+	public:
+		std::vector<uint8_t> data; // LZ block, or the raw page if it didn't compress
+		uint64_t hash = 0;
+		uint32_t nReferences = 0;
+		bool compressed = false;
+	};
+
+	class Entry
+	{
+	public:
+		std::vector<uint32_t> pages; // page indices, or ZERO_PAGE
+		uint64_t rawSize = 0;
+		int32_t prev = -1;
+		int32_t next = -1;
+		bool present = false;
+	};
+
+	std::vector<Entry> _entries; // indexed by key
+	std::vector<Page> _pages;
+	std::vector<uint32_t> _freePages;
+	std::unordered_map<uint64_t, uint32_t> _pagesByHash;
+	int32_t _lruHead = -1;
+	int32_t _lruTail = -1;
+	Stats _stats;
+
+	std::vector<uint8_t> _compressBuffer;
+	std::vector<uint8_t> _pageBuffer;
+	std::vector<uint8_t> _tailBuffer;
+
+	uint32_t StorePage(const uint8_t* page);
+	void ReleasePage(uint32_t pageIndex);
+	void ExpandPage(const Page& page, uint8_t* out);
+	void Unlink(int32_t key);
+	void PushMostRecent(int32_t key);
+	int64_t EntryOverhead(const Entry& entry) const;
+};
+
+#endif
@@ -0,0 +1,17 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+#ifndef COMPRESSION_H
+#define COMPRESSION_H
+
+// Fast LZ77 block codec in the spirit of LZ4. Blocks carry no header, so the
+// caller has to remember the uncompressed size.
+
+// Returns the compressed size, or 0 if the result would not fit in dstCapacity.
+size_t LzCompress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstCapacity);
+
+// Returns false if the block is malformed or does not decode to exactly dstSize bytes.
+bool LzDecompress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstSize);
+
+#endif
@@ -0,0 +1,96 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+
+#ifndef DISKSLOTSTORE_H
+#define DISKSLOTSTORE_H
+
+// Third savestate tier: serialized slots in a memory-mapped scratch file.
+// Insert() only queues a copy of the data; a background thread copies it into
+// the mapping and schedules writeback, so the caller never waits on the disk.
+// Like CompressedSlotStore, the owner makes room by erasing GetOldestKey().
+class DiskSlotStore
+{
+public:
+	class Stats
+	{
+	public:
+		uint64_t nEntries = 0;
+		uint64_t usedBytes = 0; // file space held by entries, rounded up to pages
+		uint64_t nInserts = 0;
+		uint64_t nReads = 0;
+		uint64_t nPendingReads = 0; // reads served before the write-behind finished
+		uint64_t bytesWritten = 0;
+		uint64_t bytesRead = 0;
+		uint64_t writeTime = 0; // spent on the background thread
+		uint64_t readTime = 0;
+	};
+
+	// Creates an anonymous scratch file of the given capacity in directory
+	DiskSlotStore(const std::filesystem::path& directory, int64_t capacity);
+	~DiskSlotStore();
+
+	DiskSlotStore(const DiskSlotStore&) = delete;
+	DiskSlotStore& operator=(const DiskSlotStore&) = delete;
+
+	bool CanFit(size_t size) const;
+	bool Insert(int32_t key, std::span<const uint8_t> data);
+	bool Contains(int32_t key) const;
+	void Read(int32_t key, std::vector<uint8_t>& out);
+	void Erase(int32_t key);
+
+	int32_t GetOldestKey() const { return _lruHead; }
+	int64_t GetCapacity() const { return _capacity; }
+	Stats GetStats() const;
+
+private:
+	class Entry
+	{
+	public:
+		int64_t offset = 0;
+		int64_t size = 0;
+		std::vector<uint8_t> pending; // data not yet copied into the mapping
+		int32_t prev = -1;
+		int32_t next = -1;
+		bool present = false;
+	};
+
+	int64_t _capacity;
+	uint8_t* _mapping = nullptr;
+#if defined(_WIN32)
+	void* _file = nullptr;
+	void* _fileMapping = nullptr;
+#else
+	int _fd = -1;
+#endif
+
+	std::vector<Entry> _entries; // indexed by key
+	std::map<int64_t, int64_t> _freeExtents; // offset -> length, coalesced
+	int32_t _lruHead = -1;
+	int32_t _lruTail = -1;
+	Stats _stats;
+
+	// Guards the pending buffers, the write queue and the statistics
+	mutable std::mutex _mutex;
+	std::condition_variable _cv;
+	std::deque<int32_t> _writeQueue;
+	int32_t _inFlight = -1; // key being copied by the writer, whose buffer must not be touched
+	bool _stopping = false;
+	std::thread _writer;
+
+	void WriterLoop();
+	void WaitForWriter(std::unique_lock<std::mutex>& lock, int32_t key);
+	int64_t AllocateExtent(int64_t size);
+	void FreeExtent(int64_t offset, int64_t size);
+	void Unlink(int32_t key);
+	void PushMostRecent(int32_t key);
+};
+
+#endif
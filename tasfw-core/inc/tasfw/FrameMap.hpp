@@ -0,0 +1,88 @@
+#pragma once
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#ifndef FRAMEMAP_H
+#define FRAMEMAP_H
+
+// Set of frames, stored as a bitmap starting at the lowest frame inserted.
+// Script frames are dense, so lookups, neighbour searches and truncation are
+// a few word operations, and clearing keeps the capacity for reuse.
+class FrameSet
+{
+public:
+	static constexpr int64_t NONE = INT64_MIN;
+
+	bool Empty() const { return _count == 0; }
+	int64_t Size() const { return _count; }
+	int64_t GetBase() const { return _base; }
+
+	bool Contains(int64_t frame) const
+	{
+		uint64_t index = uint64_t(frame - _base);
+		return index < _words.size() * 64 && (_words[index / 64] >> (index % 64) & 1);
+	}
+
+	bool Insert(int64_t frame); // false if frame was already present
+	void InsertRange(int64_t first, int64_t count);
+	void Erase(int64_t frame);
+	void EraseFrom(int64_t frame); // every frame >= frame
+	void EraseBefore(int64_t frame); // every frame < frame
+	void Clear();
+
+	int64_t FindLatest(int64_t frame) const; // greatest frame <= frame, or NONE
+	int64_t FindNext(int64_t frame) const; // least frame >= frame, or NONE
+	int64_t FindNextAbsent(int64_t frame) const; // least frame >= frame not in the set
+
+private:
+	std::vector<uint64_t> _words;
+	int64_t _base = 0; // frame of bit 0, a multiple of 64
+	int64_t _count = 0;
+};
+
+// Frame-indexed map over a FrameSet, with values in a vector at the same
+// offsets. Erasure never shrinks the allocation.
+template <class T>
+class FrameMap
+{
+public:
+	const FrameSet& Frames() const { return _frames; }
+	bool Empty() const { return _frames.Empty(); }
+	bool Contains(int64_t frame) const { return _frames.Contains(frame); }
+	int64_t FindLatest(int64_t frame) const { return _frames.FindLatest(frame); }
+	int64_t FindNext(int64_t frame) const { return _frames.FindNext(frame); }
+
+	T* Find(int64_t frame)
+	{
+		return _frames.Contains(frame) ? &*_values[frame - _frames.GetBase()] : nullptr;
+	}
+
+	// Default-constructs the value if frame is absent
+	T& operator[](int64_t frame);
+
+	// Keeps the existing value if frame is present
+	template <typename... Us>
+	T& TryEmplace(int64_t frame, Us&&... params);
+
+	void Erase(int64_t frame);
+	void EraseFrom(int64_t frame); // every frame >= frame
+	void EraseAfter(int64_t frame) { EraseFrom(frame + 1); }
+	void Clear();
+
+	// Moves every value up to lastFrame into frames target doesn't have, then
+	// clears this map
+	void MoveInto(FrameMap<T>& target, int64_t lastFrame);
+
+private:
+	FrameSet _frames;
+	std::vector<std::optional<T>> _values;
+	int64_t _valuesBase = 0;
+
+	std::optional<T>& Slot(int64_t frame);
+};
+
+//Include template method implementations
+#include "tasfw/FrameMap.t.hpp"
+
+#endif
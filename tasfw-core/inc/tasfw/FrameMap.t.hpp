@@ -0,0 +1,102 @@
+#pragma once
+#ifndef FRAMEMAP_H
+#error "FrameMap.t.hpp should only be included by FrameMap.hpp"
+#else
+
+#include <algorithm>
+#include <utility>
+
+// Must be called after frame was inserted into _frames, which fixes the base
+template <class T>
+std::optional<T>& FrameMap<T>::Slot(int64_t frame)
+{
+	int64_t base = _frames.GetBase();
+	if (_values.empty())
+		_valuesBase = base;
+	else if (base < _valuesBase)
+	{
+		// Rare: a frame below every previous one, shift everything up
+		size_t shift = size_t(_valuesBase - base);
+		size_t oldSize = _values.size();
+		_values.resize(oldSize + shift);
+		std::move_backward(_values.begin(), _values.begin() + oldSize, _values.end());
+		for (size_t i = 0; i < shift; i++)
+			_values[i].reset();
+		_valuesBase = base;
+	}
+
+	size_t index = size_t(frame - base);
+	if (index >= _values.size())
+		_values.resize(index + 1);
+
+	return _values[index];
+}
+
+template <class T>
+T& FrameMap<T>::operator[](int64_t frame)
+{
+	if (_frames.Contains(frame))
+		return *_values[frame - _frames.GetBase()];
+
+	_frames.Insert(frame);
+	return Slot(frame).emplace();
+}
+
+template <class T>
+template <typename... Us>
+T& FrameMap<T>::TryEmplace(int64_t frame, Us&&... params)
+{
+	if (_frames.Contains(frame))
+		return *_values[frame - _frames.GetBase()];
+
+	_frames.Insert(frame);
+	return Slot(frame).emplace(std::forward<Us>(params)...);
+}
+
+template <class T>
+void FrameMap<T>::Erase(int64_t frame)
+{
+	if (!_frames.Contains(frame))
+		return;
+
+	_values[frame - _frames.GetBase()].reset();
+	_frames.Erase(frame);
+}
+
+template <class T>
+void FrameMap<T>::EraseFrom(int64_t frame)
+{
+	if (_frames.Empty())
+		return;
+
+	int64_t index = (std::max)(frame - _valuesBase, int64_t(0));
+	if (index < int64_t(_values.size()))
+		_values.resize(size_t(index));
+
+	_frames.EraseFrom(frame);
+	if (_frames.Empty())
+		_values.clear();
+}
+
+template <class T>
+void FrameMap<T>::Clear()
+{
+	_values.clear();
+	_frames.Clear();
+}
+
+template <class T>
+void FrameMap<T>::MoveInto(FrameMap<T>& target, int64_t lastFrame)
+{
+	for (int64_t frame = _frames.FindNext(FrameSet::NONE);
+		frame != FrameSet::NONE && frame <= lastFrame;
+		frame = _frames.FindNext(frame + 1))
+	{
+		if (!target.Contains(frame))
+			target.TryEmplace(frame, std::move(*_values[frame - _valuesBase]));
+	}
+
+	Clear();
+}
+
+#endif
@@ -0,0 +1,66 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+#ifndef GAMESYMBOL_H
+#define GAMESYMBOL_H
+
+// Game symbols that scripts look up every frame. Each resource resolves these
+// once, so Resource::getSymbol is an array lookup instead of a dlsym or a
+// string comparison. Names must stay in the same order as GameSymbolNames.
+enum class GameSymbol : uint8_t
+{
+	gMarioStates,
+	gMarioState,
+	gMarioObject,
+	gCamera,
+	gObjectPool,
+	gControllerPads,
+	gGlobalTimer,
+	gCurrCourseNum,
+	gCurrAreaIndex,
+	bhvBitfsTiltingInvertedPyramid,
+	bhvLllTiltingInvertedPyramid,
+	bhvPlatformOnTrack,
+	mario_floor_is_slope,
+	Pyramid,
+	COUNT
+};
+
+constexpr std::array<const char*, size_t(GameSymbol::COUNT)> GameSymbolNames =
+{
+	"gMarioStates",
+	"gMarioState",
+	"gMarioObject",
+	"gCamera",
+	"gObjectPool",
+	"gControllerPads",
+	"gGlobalTimer",
+	"gCurrCourseNum",
+	"gCurrAreaIndex",
+	"bhvBitfsTiltingInvertedPyramid",
+	"bhvLllTiltingInvertedPyramid",
+	"bhvPlatformOnTrack",
+	"mario_floor_is_slope",
+	"Pyramid"
+};
+
+inline const char* GetSymbolName(GameSymbol symbol)
+{
+	return GameSymbolNames[size_t(symbol)];
+}
+
+// Returns GameSymbol::COUNT for names that aren't in the table
+inline GameSymbol FindGameSymbol(const char* name)
+{
+	for (size_t i = 0; i < GameSymbolNames.size(); i++)
+	{
+		if (strcmp(GameSymbolNames[i], name) == 0)
+			return GameSymbol(i);
+	}
+
+	return GameSymbol::COUNT;
+}
+
+#endif
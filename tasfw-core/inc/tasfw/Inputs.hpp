@@ -2,6 +2,9 @@
 #include <cstdint>
 #include <filesystem>
 #include <map>
+#include <span>
+#include <vector>
+#include <tasfw/FrameMap.hpp>
 #include <tasfw/SharedLib.hpp>
 
 #ifndef INPUTS_H
@@ -91,10 +94,73 @@ public:
 	static bool HauEquals(int16_t angle1, int16_t angle2);
 };
 
+// Inputs by frame, as a dense vector from the lowest frame set plus a bitmap
+// of the frames that are present. Movies fill it from frame 0 and diffs cover
+// a few contiguous runs, so lookups are an index and merges and truncation
+// work a run at a time.
+class InputTimeline
+{
+public:
+	bool Empty() const { return _frames.Empty(); }
+	int64_t Size() const { return _frames.Size(); }
+	bool Contains(int64_t frame) const { return _frames.Contains(frame); }
+
+	const Inputs* Find(int64_t frame) const
+	{
+		return _frames.Contains(frame) ? &_inputs[frame - _frames.GetBase()] : nullptr;
+	}
+
+	// Must not be empty
+	int64_t First() const { return _frames.FindNext(FrameSet::NONE); }
+	int64_t Last() const { return _frames.FindLatest(INT64_MAX); }
+
+	int64_t FindNext(int64_t frame) const { return _frames.FindNext(frame); } // FrameSet::NONE if none
+	int64_t FindLatest(int64_t frame) const { return _frames.FindLatest(frame); }
+
+	void Set(int64_t frame, Inputs inputs);
+	void SetRange(int64_t firstFrame, std::span<const Inputs> inputs);
+	// Copies every frame of other, keeping this timeline's frames unless overwrite
+	void Merge(const InputTimeline& other, bool overwrite = true);
+
+	void EraseFrom(int64_t frame); // every frame >= frame
+	void EraseBefore(int64_t frame); // every frame < frame
+	void Clear();
+
+	// f(firstFrame, inputs) for every run of consecutive frames, in order
+	template <typename F>
+	void ForEachSpan(F&& f) const
+	{
+		for (int64_t first = _frames.FindNext(FrameSet::NONE); first != FrameSet::NONE;)
+		{
+			int64_t end = _frames.FindNextAbsent(first);
+			f(first, std::span<const Inputs>(&_inputs[first - _frames.GetBase()], size_t(end - first)));
+			first = _frames.FindNext(end);
+		}
+	}
+
+	// f(frame, inputs) for every frame, in order
+	template <typename F>
+	void ForEach(F&& f) const
+	{
+		ForEachSpan([&](int64_t firstFrame, std::span<const Inputs> inputs)
+		{
+			for (size_t i = 0; i < inputs.size(); i++)
+				f(firstFrame + int64_t(i), inputs[i]);
+		});
+	}
+
+private:
+	FrameSet _frames;
+	std::vector<Inputs> _inputs; // indexed from the bitmap base
+	int64_t _inputsBase = 0;
+
+	Inputs* GetStorage(int64_t firstFrame, size_t count);
+};
+
 class M64Base
 {
 public:
-	std::map<uint64_t, Inputs> frames;
+	InputTimeline frames;
 
 	M64Base() = default;
 };
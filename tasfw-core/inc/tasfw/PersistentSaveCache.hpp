@@ -0,0 +1,45 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <set>
+#include <span>
+#include <vector>
+
+#ifndef PERSISTENTSAVECACHE_H
+#define PERSISTENTSAVECACHE_H
+
+// Serialized savestates kept on disk across runs, keyed by (resource key,
+// hash of all inputs before the frame, frame). The resource key identifies the
+// game binary and state format, so a rebuilt DLL never sees stale states.
+//
+// Layout: <directory>/<resource key>/<frame>-<input prefix hash>.sav
+class PersistentSaveCache
+{
+public:
+	uint64_t nHits = 0;
+	uint64_t nMisses = 0; // entries that were found but failed validation
+	uint64_t nWrites = 0;
+	uint64_t writeTicks = 0; // get_time() ticks spent saving, serializing and writing entries
+
+	PersistentSaveCache(const std::filesystem::path& directory, uint64_t resourceKey);
+
+	bool Contains(int64_t frame, uint64_t inputPrefixHash) const;
+	// Frames with at least one entry in [minFrame, maxFrame], deepest first
+	std::vector<int64_t> GetFrames(int64_t minFrame, int64_t maxFrame) const;
+	bool Read(int64_t frame, uint64_t inputPrefixHash, std::vector<uint8_t>& out);
+	void Write(int64_t frame, uint64_t inputPrefixHash, std::span<const uint8_t> data);
+	// Forgets an entry, e.g. one the resource can't load, so it gets rewritten
+	void Erase(int64_t frame, uint64_t inputPrefixHash);
+
+	static uint64_t HashBytes(const void* data, size_t size, uint64_t seed = 0xcbf29ce484222325ull);
+	static uint64_t HashFile(const std::filesystem::path& path);
+
+private:
+	std::filesystem::path _directory;
+	std::map<int64_t, std::set<uint64_t>> _entries;
+
+	std::filesystem::path GetEntryPath(int64_t frame, uint64_t inputPrefixHash) const;
+};
+
+#endif
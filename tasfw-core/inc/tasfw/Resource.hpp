@@ -1,10 +1,23 @@
 #pragma once
 
+#include <array>
 #include <cstring>
 #include <iostream>
+#include <memory>
+#include <set>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
 #include <vector>
 
+#include <tasfw/CompressedSlotStore.hpp>
+#include <tasfw/DiskSlotStore.hpp>
+#include <tasfw/GameSymbol.hpp>
 #include <tasfw/Inputs.hpp>
+#include <tasfw/PersistentSaveCache.hpp>
+#include <tasfw/ResourceStats.hpp>
+#include <tasfw/SaveMemoryGovernor.hpp>
 #include <tasfw/SharedLib.hpp>
 
 #include <cstdlib>
@@ -28,26 +41,210 @@ public:
 	ImportedSave(TState state, int64_t initialFrame) : state(state), initialFrame(initialFrame) {}
 };
 
+template <class TState>
+class SlotManager;
+
+// Decides which slot to give up when the slot manager runs out of save memory.
+template <class TState>
+class SlotEvictionPolicy
+{
+public:
+	virtual ~SlotEvictionPolicy() = default;
+
+	virtual void OnCreate(SlotManager<TState>&, int32_t) { }
+	virtual void OnLoad(SlotManager<TState>&, int32_t) { }
+	virtual void OnErase(SlotManager<TState>&, int32_t) { }
+	virtual int32_t SelectVictim(SlotManager<TState>& manager) = 0;
+};
+
+// Evicts the least recently created or loaded slot.
+template <class TState>
+class LruEvictionPolicy : public SlotEvictionPolicy<TState>
+{
+public:
+	int32_t SelectVictim(SlotManager<TState>& manager) override;
+};
+
+// GreedyDual-Size: a slot is worth the time it would take to re-simulate it
+// from the nearest earlier surviving save, divided by its size. The cheapest
+// slot per byte is evicted, and the inflation value ages slots that have not
+// been touched since. Priorities are kept ordered and only recomputed for a
+// slot and its successor when they change, so eviction is O(log n).
+template <class TState>
+class GreedyDualSizePolicy : public SlotEvictionPolicy<TState>
+{
+public:
+	void OnCreate(SlotManager<TState>& manager, int32_t slotIndex) override;
+	void OnLoad(SlotManager<TState>& manager, int32_t slotIndex) override;
+	void OnErase(SlotManager<TState>& manager, int32_t slotIndex) override;
+	int32_t SelectVictim(SlotManager<TState>& manager) override;
+
+private:
+	using FrameIterator = typename std::set<std::pair<int64_t, int32_t>>::iterator;
+
+	double _inflation = 0;
+	std::vector<double> _credit; // inflation value at last access, by slot index
+	std::vector<double> _priority; // key in _slotsByPriority, by slot index
+	std::set<std::pair<int64_t, int32_t>> _slotsByFrame;
+	std::set<std::pair<double, int32_t>> _slotsByPriority;
+
+	void UpdatePriority(SlotManager<TState>& manager, FrameIterator entry);
+};
+
+// Decides whether saving or loading beats frame advancing. The resource
+// reports every timed operation to it, in get_time() ticks.
+template <class TState>
+class SaveCostModel
+{
+public:
+	uint64_t nSaveDecisions = 0; // calls that weren't trivially answered
+	uint64_t nSavesTaken = 0;
+	uint64_t nLoadDecisions = 0;
+	uint64_t nLoadsTaken = 0;
+
+	virtual ~SaveCostModel() = default;
+
+	virtual void OnAdvance(uint64_t ticks, uint64_t nFrames) = 0;
+	virtual void OnSave(uint64_t ticks, int64_t size) = 0;
+	virtual void OnLoad(uint64_t ticks) = 0;
+	virtual bool ShouldSave(const Resource<TState>& resource, int64_t estFrameAdvances) = 0;
+	virtual bool ShouldLoad(const Resource<TState>& resource, int64_t framesAhead) = 0;
+};
+
+// Compares lifetime averages of save, load and advance time.
+template <class TState>
+class LifetimeAverageCostModel : public SaveCostModel<TState>
+{
+public:
+	void OnAdvance(uint64_t ticks, uint64_t nFrames) override;
+	void OnSave(uint64_t ticks, int64_t size) override;
+	void OnLoad(uint64_t ticks) override;
+	bool ShouldSave(const Resource<TState>& resource, int64_t estFrameAdvances) override;
+	bool ShouldLoad(const Resource<TState>& resource, int64_t framesAhead) override;
+
+private:
+	uint64_t _advanceTicks = 0;
+	uint64_t _nFrames = 0;
+	uint64_t _saveTicks = 0;
+	uint64_t _nSaves = 0;
+	uint64_t _loadTicks = 0;
+	uint64_t _nLoads = 0;
+};
+
+// Exponentially decayed averages, so estimates follow the workload within a
+// few hundred operations. A save is also charged for the budget it uses: it
+// costs up to twice its time once the slot memory is full, since every save
+// then evicts one.
+template <class TState>
+class DecayedCostModel : public SaveCostModel<TState>
+{
+public:
+	double halfLife = 256; // operations of the same kind, a batch counts each frame
+
+	void OnAdvance(uint64_t ticks, uint64_t nFrames) override;
+	void OnSave(uint64_t ticks, int64_t size) override;
+	void OnLoad(uint64_t ticks) override;
+	bool ShouldSave(const Resource<TState>& resource, int64_t estFrameAdvances) override;
+	bool ShouldLoad(const Resource<TState>& resource, int64_t framesAhead) override;
+
+private:
+	double _advanceTicks = -1; // per frame, -1 until the first sample
+	double _saveTicks = -1;
+	double _saveSize = 0;
+	double _loadTicks = -1;
+
+	void Update(double& estimate, double sample, uint64_t weight) const;
+	void LogDecisions(const Resource<TState>& resource) const;
+};
+
+enum class SlotTier : uint8_t
+{
+	FREE,
+	RAM,
+	COMPRESSED,
+	DISK
+};
+
 template <class TState>
 class SlotManager
 {
 public:
+	// Slot records live in a slab and are reused once freed, so that creating,
+	// touching and evicting a slot never allocates in steady state.
+	class Slot
+	{
+	public:
+		TState state; // empty while the slot lives in a lower tier
+		int64_t id = 0; // 0 while the record is on the free list
+		int64_t size = 0;
+		SlotTier tier = SlotTier::FREE;
+		int64_t frame = 0;
+		uint32_t generation = 0;
+		uint64_t epoch = 0; // getStateEpoch() when saved
+		int32_t prev = -1; // less recently used neighbour
+		int32_t next = -1; // more recently used neighbour, or next free record
+	};
+
 	Resource<TState>* _resource = NULL;
-	std::map<int64_t, TState> slotsById;
-	std::map<int64_t, int64_t> slotIdsByLastAccess;
-	std::map<int64_t, int64_t> slotLastAccessOrderById;
-	int64_t nextSlotId = 1; //slot IDs are unique
+	std::vector<Slot> slots;
+	int32_t lruHead = -1; // least recently used slot
+	int32_t lruTail = -1; // most recently used slot
+	int32_t freeHead = -1;
+	int64_t nSlots = 0; // slots resident in RAM
 
 	int64_t _saveMemLimit = 0;
-	int64_t _currentSaveMem = 0;
+	int64_t _currentSaveMem = 0; // slots in RAM plus what the resource shares between them
+	int64_t _slotSaveMem = 0;
+
+	std::unique_ptr<SlotEvictionPolicy<TState>> evictionPolicy = std::make_unique<LruEvictionPolicy<TState>>();
+	uint64_t nHits = 0; // loads of a live slot
+	uint64_t nMisses = 0; // loads asked for a slot that has already been evicted
+	uint64_t nEvictions = 0;
+	uint64_t nPromotions = 0; // hits that had to bring the slot back from a lower tier
+
+	// Evicted slots are demoted through these tiers instead of being dropped,
+	// if the resource can serialize its state: RAM -> compressed -> disk.
+	std::unique_ptr<CompressedSlotStore> compressedTier;
+	std::unique_ptr<DiskSlotStore> diskTier;
+
+	// If set, this share of a global budget covers the RAM and compressed
+	// tiers, split between them as they were configured when it was set
+	std::shared_ptr<SaveMemoryGovernor::Share> memoryShare;
 
 	SlotManager(Resource<TState>* resource) : _resource(resource) { }
 
+	void SetEvictionPolicy(std::unique_ptr<SlotEvictionPolicy<TState>> policy);
+	void EnableCompressedTier(int64_t memLimit);
+	void EnableDiskTier(const std::filesystem::path& directory, int64_t capacity);
+	void SetMemoryGovernor(SaveMemoryGovernor& governor);
 	int64_t CreateSlot();
+	void EvictSlot();
 	void EraseOldestSlot();
 	void EraseSlot(int64_t slotId);
 	void LoadSlot(int64_t slotId);
-	bool isValid(int64_t slotId);
+	bool isValid(int64_t slotId) const;
+	// Load path: drops a slot that can't be restored exactly anymore, and
+	// counts a miss if the slot is gone. Returns whether it can be loaded.
+	bool PrepareLoad(int64_t slotId);
+	int64_t GetSlotSize(int64_t slotId) const; // 0 for invalid slots
+
+private:
+	// Slot IDs are (generation << 32 | slab index), so resolving an ID is a
+	// single array lookup and stale IDs are rejected by the generation check.
+	int32_t GetSlotIndex(int64_t slotId) const;
+	int32_t AllocateSlotIndex();
+	void Unlink(int32_t slotIndex);
+	void PushMostRecent(int32_t slotIndex);
+	void ReleaseSlot(int32_t slotIndex);
+	bool Demote(int32_t slotIndex);
+	void Spill(int32_t slotIndex, std::span<const uint8_t> data);
+	void Promote(int32_t slotIndex);
+	void SyncMemoryShare();
+	void UpdateSaveMem();
+
+	double _compressedShare = 0; // of memoryShare, given to the compressed tier
+
+	std::vector<uint8_t> _serializeBuffer;
 };
 
 // Interface for the state machine that represents the game. Can either contain the state machine itself, or be a client to an external state machine.
@@ -61,21 +258,55 @@ public:
 	uint64_t nFrameAdvances = 0;
 	uint64_t nLoadStates = 0;
 	uint64_t nSaveStates = 0;
+	uint64_t nResimulatedFrames = 0; // frames replayed to reach a load target
+
+	std::unique_ptr<SaveCostModel<TState>> costModel = std::make_unique<DecayedCostModel<TState>>();
+
+	// Latencies in nanoseconds and byte counts, queryable at any time. If
+	// statsPath is set, GetStatsJson() is written there on destruction.
+	ResourceStats stats;
+	std::filesystem::path statsPath;
 
 	TState startSave = TState();
 	int64_t initialFrame = 0;
 	SlotManager<TState> slotManager = SlotManager<TState>(this);
+	std::unique_ptr<PersistentSaveCache> persistentCache; // only used when starting from power-on
 
 	Resource() = default;
+	virtual ~Resource();
 
 	Resource(const Resource<TState>&) = delete;
 	Resource& operator= (const Resource<TState>&) = delete;
 
 	int64_t SaveState();
 	void LoadState(int64_t slotId);
+	// Callers that know the concrete resource pass it as TDerived, so that
+	// advance() of a final resource is called directly instead of through
+	// the vtable.
+	template <class TDerived = Resource<TState>>
 	void FrameAdvance();
+	// Advances one frame per entry, with that entry's inputs on the controller.
+	// Timed as one batch, so the bookkeeping is paid once instead of per frame.
+	template <class TDerived = Resource<TState>>
+	void FrameAdvance(std::span<const Inputs> inputs);
+	void SetInputs(Inputs inputs);
 	bool shouldSave(int64_t framesSinceLastSave) const;
 	bool shouldLoad(int64_t framesAhead) const;
+	void SetCostModel(std::unique_ptr<SaveCostModel<TState>> model);
+	double getFrameAdvanceTime() const;
+	void EnablePersistentCache(const std::filesystem::path& directory);
+	std::string GetStatsJson() const;
+
+	// Typed address of a game symbol, resolved when the resource was constructed
+	template <class T = void>
+	T* getSymbol(GameSymbol symbol) const
+	{
+		void* address = _symbols[size_t(symbol)];
+		if (!address)
+			throw std::runtime_error(std::string("Unable to resolve symbol \"") + GetSymbolName(symbol) + "\"");
+
+		return static_cast<T*>(address);
+	}
 
 	//Return a conversion of the current state for the user to do with as they like (e.g. pass to a new top-level script)
 	//Requires a matching constructor in the return type that will convert TState to the return type
@@ -89,10 +320,38 @@ public:
 	virtual void save(TState& state) const = 0;
 	virtual void load(const TState& state) = 0;
 	virtual void advance() = 0;
+	// Resources can override this to avoid a virtual advance() per frame
+	virtual void advanceFrames(std::span<const Inputs> inputs);
 	virtual void* addr(const char* symbol) const = 0;
 	virtual std::size_t getStateSize(const TState& state) const = 0;
 	//TODO: make this resource-agnostic
 	virtual uint32_t getCurrentFrame() const = 0;
+
+	// Optional flat encoding of a state, used by the compressed slot tier.
+	// Returns false if the resource doesn't support it.
+	virtual bool serialize(const TState&, std::vector<uint8_t>&) const { return false; }
+	virtual bool deserialize(std::span<const uint8_t>, TState&) const { return false; }
+	// Identifies the game binary and serialization format for states saved
+	// across runs. 0 means states must not outlive the process.
+	virtual uint64_t getPersistentKey() const { return 0; }
+	// Optional sharing of data between states, e.g. deduplicated pages.
+	// getStateSize() then counts only what a state owns, and shared data is
+	// charged once here. releaseState() drops a freed slot's references while
+	// its record is kept for reuse.
+	virtual std::size_t getSharedStateSize() const { return 0; }
+	virtual void releaseState(TState&) const { }
+	// States saved while the resource reported another nonzero epoch can't be
+	// restored exactly anymore, and are dropped like evicted ones. 0 marks
+	// states that stay exact.
+	virtual uint64_t getStateEpoch() const { return 0; }
+
+protected:
+	std::array<void*, size_t(GameSymbol::COUNT)> _symbols = {};
+	const double _nsPerTick = GetNanosecondsPerTick();
+
+	// Fills the symbol table through addr(). Symbols the game doesn't export
+	// stay null. Call at the end of the derived constructor.
+	void ResolveSymbols();
 };
 
 //Include template method implementations
@@ -3,7 +3,13 @@
 #error "Resource.t.hpp should only be included by Resource.hpp"
 #else
 
+#include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <sstream>
 
 #ifdef _MSC_VER
 #include <intrin.h>
@@ -30,88 +36,599 @@ static inline uint64_t get_time()
 #endif
 
 template <class TState>
-bool SlotManager<TState>::isValid(int64_t slotId)
+int32_t LruEvictionPolicy<TState>::SelectVictim(SlotManager<TState>& manager)
 {
-	return slotsById.contains(slotId);
+	return manager.lruHead;
+}
+
+template <class TState>
+void LifetimeAverageCostModel<TState>::OnAdvance(uint64_t ticks, uint64_t nFrames)
+{
+	_advanceTicks += ticks;
+	_nFrames += nFrames;
+}
+
+template <class TState>
+void LifetimeAverageCostModel<TState>::OnSave(uint64_t ticks, int64_t)
+{
+	_saveTicks += ticks;
+	_nSaves++;
+}
+
+template <class TState>
+void LifetimeAverageCostModel<TState>::OnLoad(uint64_t ticks)
+{
+	_loadTicks += ticks;
+	_nLoads++;
+}
+
+template <class TState>
+bool LifetimeAverageCostModel<TState>::ShouldSave(const Resource<TState>&, int64_t estFrameAdvances)
+{
+	if (estFrameAdvances == 0)
+		return false;
+
+	this->nSaveDecisions++;
+	bool save = _nSaves == 0 || _nFrames == 0 || estFrameAdvances < 0 ||
+		double(_saveTicks) / _nSaves < (double(_advanceTicks) / _nFrames) * estFrameAdvances;
+	this->nSavesTaken += save;
+	return save;
+}
+
+template <class TState>
+bool LifetimeAverageCostModel<TState>::ShouldLoad(const Resource<TState>&, int64_t framesAhead)
+{
+	if (framesAhead == 0)
+		return false;
+
+	this->nLoadDecisions++;
+	bool load = _nLoads == 0 || _nFrames == 0 || framesAhead < 0 ||
+		double(_loadTicks) / _nLoads < (double(_advanceTicks) / _nFrames) * framesAhead;
+	this->nLoadsTaken += load;
+	return load;
+}
+
+template <class TState>
+void DecayedCostModel<TState>::Update(double& estimate, double sample, uint64_t weight) const
+{
+	if (estimate < 0)
+	{
+		estimate = sample;
+		return;
+	}
+
+	// Same as applying the sample weight times
+	double keep = std::exp2(-double(weight) / halfLife);
+	estimate = estimate * keep + sample * (1 - keep);
+}
+
+template <class TState>
+void DecayedCostModel<TState>::OnAdvance(uint64_t ticks, uint64_t nFrames)
+{
+	Update(_advanceTicks, double(ticks) / nFrames, nFrames);
+}
+
+template <class TState>
+void DecayedCostModel<TState>::OnSave(uint64_t ticks, int64_t size)
+{
+	bool first = _saveTicks < 0;
+	Update(_saveTicks, double(ticks), 1);
+	if (first)
+		_saveSize = double(size);
+	else
+		Update(_saveSize, double(size), 1);
+}
+
+template <class TState>
+void DecayedCostModel<TState>::OnLoad(uint64_t ticks)
+{
+	Update(_loadTicks, double(ticks), 1);
+}
+
+template <class TState>
+bool DecayedCostModel<TState>::ShouldSave(const Resource<TState>& resource, int64_t estFrameAdvances)
+{
+	if (estFrameAdvances == 0)
+		return false;
+
+	bool save = true;
+	if (_saveTicks >= 0 && _advanceTicks >= 0 && estFrameAdvances >= 0)
+	{
+		const SlotManager<TState>& slots = resource.slotManager;
+		double fill = slots._saveMemLimit > 0
+			? (std::min)(1.0, (double(slots._currentSaveMem) + _saveSize) / double(slots._saveMemLimit))
+			: 0.0;
+		save = _saveTicks * (1 + fill) < _advanceTicks * double(estFrameAdvances);
+	}
+
+	this->nSaveDecisions++;
+	this->nSavesTaken += save;
+#ifndef NDEBUG
+	LogDecisions(resource);
+#endif
+	return save;
+}
+
+template <class TState>
+bool DecayedCostModel<TState>::ShouldLoad(const Resource<TState>& resource, int64_t framesAhead)
+{
+	if (framesAhead == 0)
+		return false;
+
+	bool load = _loadTicks < 0 || _advanceTicks < 0 || framesAhead < 0 ||
+		_loadTicks < _advanceTicks * double(framesAhead);
+
+	this->nLoadDecisions++;
+	this->nLoadsTaken += load;
+#ifndef NDEBUG
+	LogDecisions(resource);
+#endif
+	return load;
+}
+
+// Debug builds print a summary every so many decisions, cheap enough to
+// leave on while tuning a script
+template <class TState>
+void DecayedCostModel<TState>::LogDecisions(const Resource<TState>& resource) const
+{
+	if ((this->nSaveDecisions + this->nLoadDecisions) % 100000 != 0)
+		return;
+
+	std::cerr << "cost model: advance " << _advanceTicks
+		<< " save " << _saveTicks << " (" << int64_t(_saveSize) << " B)"
+		<< " load " << _loadTicks << " ticks; saved "
+		<< this->nSavesTaken << "/" << this->nSaveDecisions << ", loaded "
+		<< this->nLoadsTaken << "/" << this->nLoadDecisions << ", resimulated "
+		<< resource.nResimulatedFrames << " frames\n";
+}
+
+// Losing a slot means replaying from the closest earlier save instead. The
+// frame advance time is sampled whenever a priority is recomputed.
+template <class TState>
+void GreedyDualSizePolicy<TState>::UpdatePriority(SlotManager<TState>& manager, FrameIterator entry)
+{
+	auto [frame, slotIndex] = *entry;
+	int64_t previousFrame = entry == _slotsByFrame.begin() ? manager._resource->initialFrame : std::prev(entry)->first;
+
+	double resimulationCost = double(frame - previousFrame) * manager._resource->getFrameAdvanceTime();
+	double priority = _credit[slotIndex] + resimulationCost / double((std::max)(manager.slots[slotIndex].size, int64_t(1)));
+
+	_slotsByPriority.erase(std::pair(_priority[slotIndex], slotIndex));
+	_priority[slotIndex] = priority;
+	_slotsByPriority.emplace(priority, slotIndex);
+}
+
+template <class TState>
+void GreedyDualSizePolicy<TState>::OnCreate(SlotManager<TState>& manager, int32_t slotIndex)
+{
+	if (_credit.size() <= static_cast<size_t>(slotIndex))
+	{
+		_credit.resize(manager.slots.size());
+		_priority.resize(manager.slots.size());
+	}
+
+	_credit[slotIndex] = _inflation;
+
+	//The next slot now replays from this one
+	auto entry = _slotsByFrame.emplace(manager.slots[slotIndex].frame, slotIndex).first;
+	UpdatePriority(manager, entry);
+	if (std::next(entry) != _slotsByFrame.end())
+		UpdatePriority(manager, std::next(entry));
+}
+
+template <class TState>
+void GreedyDualSizePolicy<TState>::OnLoad(SlotManager<TState>& manager, int32_t slotIndex)
+{
+	_credit[slotIndex] = _inflation;
+
+	auto entry = _slotsByFrame.find(std::pair(manager.slots[slotIndex].frame, slotIndex));
+	if (entry != _slotsByFrame.end())
+		UpdatePriority(manager, entry);
+}
+
+template <class TState>
+void GreedyDualSizePolicy<TState>::OnErase(SlotManager<TState>& manager, int32_t slotIndex)
+{
+	auto entry = _slotsByFrame.find(std::pair(manager.slots[slotIndex].frame, slotIndex));
+	if (entry == _slotsByFrame.end())
+		return;
+
+	_slotsByPriority.erase(std::pair(_priority[slotIndex], slotIndex));
+
+	//The next slot now replays from the one before this
+	auto next = _slotsByFrame.erase(entry);
+	if (next != _slotsByFrame.end())
+		UpdatePriority(manager, next);
+}
+
+template <class TState>
+int32_t GreedyDualSizePolicy<TState>::SelectVictim(SlotManager<TState>&)
+{
+	if (_slotsByPriority.empty())
+		return -1;
+
+	auto [priority, victim] = *_slotsByPriority.begin();
+	_inflation = priority;
+	return victim;
+}
+
+template <class TState>
+void SlotManager<TState>::SetEvictionPolicy(std::unique_ptr<SlotEvictionPolicy<TState>> policy)
+{
+	evictionPolicy = std::move(policy);
+	for (int32_t slotIndex = lruHead; slotIndex != -1; slotIndex = slots[slotIndex].next)
+		evictionPolicy->OnCreate(*this, slotIndex);
+}
+
+template <class TState>
+void SlotManager<TState>::EnableCompressedTier(int64_t memLimit)
+{
+	if (compressedTier)
+		compressedTier->memLimit = memLimit;
+	else
+		compressedTier = std::make_unique<CompressedSlotStore>(memLimit);
+}
+
+template <class TState>
+void SlotManager<TState>::EnableDiskTier(const std::filesystem::path& directory, int64_t capacity)
+{
+	if (diskTier)
+		throw std::runtime_error("Disk tier is already enabled.");
+
+	diskTier = std::make_unique<DiskSlotStore>(directory, capacity);
+}
+
+template <class TState>
+int32_t SlotManager<TState>::GetSlotIndex(int64_t slotId) const
+{
+	if (slotId <= 0)
+		return -1;
+
+	int64_t slotIndex = slotId & 0xFFFFFFFF;
+	if (slotIndex >= static_cast<int64_t>(slots.size()) || slots[slotIndex].id != slotId)
+		return -1;
+
+	return static_cast<int32_t>(slotIndex);
+}
+
+template <class TState>
+int32_t SlotManager<TState>::AllocateSlotIndex()
+{
+	int32_t slotIndex = freeHead;
+	if (slotIndex == -1)
+	{
+		slotIndex = static_cast<int32_t>(slots.size());
+		slots.emplace_back();
+	}
+	else
+		freeHead = slots[slotIndex].next;
+
+	Slot& slot = slots[slotIndex];
+
+	//NOTE: IDs will not overflow on realistic timescales
+	if (++slot.generation == 0x80000000)
+		throw std::runtime_error("Max slot id exceeded.");
+
+	slot.id = (static_cast<int64_t>(slot.generation) << 32) | slotIndex;
+	return slotIndex;
+}
+
+template <class TState>
+void SlotManager<TState>::Unlink(int32_t slotIndex)
+{
+	Slot& slot = slots[slotIndex];
+
+	if (slot.prev == -1)
+		lruHead = slot.next;
+	else
+		slots[slot.prev].next = slot.next;
+
+	if (slot.next == -1)
+		lruTail = slot.prev;
+	else
+		slots[slot.next].prev = slot.prev;
+
+	slot.prev = -1;
+	slot.next = -1;
+}
+
+template <class TState>
+void SlotManager<TState>::PushMostRecent(int32_t slotIndex)
+{
+	Slot& slot = slots[slotIndex];
+	slot.prev = lruTail;
+	slot.next = -1;
+
+	if (lruTail == -1)
+		lruHead = slotIndex;
+	else
+		slots[lruTail].next = slotIndex;
+
+	lruTail = slotIndex;
+}
+
+template <class TState>
+bool SlotManager<TState>::isValid(int64_t slotId) const
+{
+	int32_t slotIndex = GetSlotIndex(slotId);
+	if (slotIndex == -1)
+		return false;
+
+	uint64_t epoch = slots[slotIndex].epoch;
+	return epoch == 0 || epoch == _resource->getStateEpoch();
+}
+
+template <class TState>
+bool SlotManager<TState>::PrepareLoad(int64_t slotId)
+{
+	if (isValid(slotId))
+		return true;
+
+	if (GetSlotIndex(slotId) != -1)
+		EraseSlot(slotId);
+	if (slotId > 0)
+		nMisses++;
+	return false;
+}
+
+template <class TState>
+void SlotManager<TState>::SetMemoryGovernor(SaveMemoryGovernor& governor)
+{
+	if (compressedTier && compressedTier->memLimit > 0)
+		_compressedShare = double(compressedTier->memLimit) / double(_saveMemLimit + compressedTier->memLimit);
+
+	memoryShare = governor.Register();
+	SyncMemoryShare();
+}
+
+// The governor weighs RAM misses, so hits served by a lower tier count as misses
+template <class TState>
+void SlotManager<TState>::SyncMemoryShare()
+{
+	int64_t limit = memoryShare->Report(nHits - nPromotions, nMisses + nPromotions);
+	if (!compressedTier)
+	{
+		_saveMemLimit = limit;
+		return;
+	}
+
+	// A shrunken compressed tier is trimmed on the next demotion
+	compressedTier->memLimit = int64_t(double(limit) * _compressedShare);
+	_saveMemLimit = limit - compressedTier->memLimit;
 }
 
 template <class TState>
 int64_t SlotManager<TState>::CreateSlot()
 {
+	// A shrunken share is enforced by the eviction loop below
+	if (memoryShare)
+		SyncMemoryShare();
+
 	while (true)
 	{
-		int64_t additionalMem = slotsById.empty() ? 0 : _currentSaveMem / slotsById.size();
+		int64_t additionalMem = nSlots == 0 ? 0 : _currentSaveMem / nSlots;
 		if (_currentSaveMem + additionalMem <= _saveMemLimit)
 		{
-			//NOTE: IDs/Order will not overflow on realistic timescales
-			int64_t slotId = nextSlotId++;
-			if (nextSlotId == 1)
-				throw std::runtime_error("Max slot id exceeded.");
-			slotsById[slotId] = TState();
+			int32_t slotIndex = AllocateSlotIndex();
+			PushMostRecent(slotIndex);
+			nSlots++;
+
+			//Save memory into slot. The record's state is reused from its previous occupant.
+			Slot& slot = slots[slotIndex];
+			slot.tier = SlotTier::RAM;
+			_resource->save(slot.state);
+			slot.epoch = _resource->getStateEpoch();
+			slot.size = _resource->getStateSize(slot.state);
+			slot.frame = _resource->getCurrentFrame();
+			_slotSaveMem += slot.size;
+			UpdateSaveMem();
+			evictionPolicy->OnCreate(*this, slotIndex);
+
+			return slot.id;
+		}
 
-			//NOTE: Order will not overflow on realistic timescales
-			int64_t newSlotOrder = slotIdsByLastAccess.size() == 0 ? 0 : std::prev(slotIdsByLastAccess.end())->first + 1;
-			if (slotIdsByLastAccess.size() != 0 && newSlotOrder == 0)
-				throw std::runtime_error("Max slot touches exceeded.");
+		if (nSlots == 0)
+			throw std::runtime_error("Not enough resource slot memory allocated");
 
-			slotIdsByLastAccess[newSlotOrder] = slotId;
-			slotLastAccessOrderById[slotId] = newSlotOrder;
+		// If save memory is full, remove the least valuable save and try again
+		EvictSlot();
+	}
+}
 
-			//Save memory into slot
-			_resource->save(slotsById[slotId]);
-			_currentSaveMem += _resource->getStateSize(slotsById[slotId]);
+template <class TState>
+void SlotManager<TState>::ReleaseSlot(int32_t slotIndex)
+{
+	Slot& slot = slots[slotIndex];
+	_resource->releaseState(slot.state);
+	slot.size = 0;
+	slot.id = 0;
+	slot.tier = SlotTier::FREE;
+	slot.next = freeHead;
+	freeHead = slotIndex;
+	UpdateSaveMem();
+}
 
-			return slotId;
-		}
+template <class TState>
+void SlotManager<TState>::UpdateSaveMem()
+{
+	_currentSaveMem = _slotSaveMem + static_cast<int64_t>(_resource->getSharedStateSize());
+}
 
-		if (slotsById.size() == 0)
-			throw std::runtime_error("Not enough resource slot memory allocated");
+template <class TState>
+void SlotManager<TState>::EraseSlot(int64_t slotId)
+{
+	int32_t slotIndex = GetSlotIndex(slotId);
+	if (slotIndex == -1)
+		return;
 
-		// If save memory is full, remove the earliest save and try again
-		EraseOldestSlot();
+	Slot& slot = slots[slotIndex];
+	if (slot.tier == SlotTier::COMPRESSED)
+		compressedTier->Erase(slotIndex);
+	else if (slot.tier == SlotTier::DISK)
+		diskTier->Erase(slotIndex);
+	else
+	{
+		evictionPolicy->OnErase(*this, slotIndex);
+		Unlink(slotIndex);
+		_slotSaveMem -= slot.size;
+		nSlots--;
 	}
+
+	ReleaseSlot(slotIndex);
 }
 
 template <class TState>
-void SlotManager<TState>::EraseSlot(int64_t slotId)
+bool SlotManager<TState>::Demote(int32_t slotIndex)
 {
-	if (slotsById.contains(slotId))
+	if (!compressedTier && !diskTier)
+		return false;
+
+	Slot& slot = slots[slotIndex];
+	if (!_resource->serialize(slot.state, _serializeBuffer))
+		return false;
+
+	evictionPolicy->OnErase(*this, slotIndex);
+	Unlink(slotIndex);
+	_slotSaveMem -= slot.size;
+	nSlots--;
+	slot.state = TState(); // give the RAM copy back
+	UpdateSaveMem();
+
+	if (!compressedTier)
 	{
-		_currentSaveMem -= _resource->getStateSize(slotsById[slotId]);
+		Spill(slotIndex, _serializeBuffer);
+		return true;
+	}
 
-		int64_t slotOrder = slotLastAccessOrderById[slotId];
-		slotsById.erase(slotId);
-		slotLastAccessOrderById.erase(slotId);
-		slotIdsByLastAccess.erase(slotOrder);
+	compressedTier->Insert(slotIndex, _serializeBuffer);
+	slot.tier = SlotTier::COMPRESSED;
+
+	// The compressed tier passes its least recently used entries down
+	while (compressedTier->IsOverBudget())
+	{
+		int32_t oldest = compressedTier->GetOldestKey();
+		if (oldest == -1)
+			break;
+
+		if (diskTier)
+			compressedTier->Read(oldest, _serializeBuffer);
+		compressedTier->Erase(oldest);
+		Spill(oldest, _serializeBuffer);
+	}
+
+	return true;
+}
+
+template <class TState>
+void SlotManager<TState>::Spill(int32_t slotIndex, std::span<const uint8_t> data)
+{
+	if (diskTier)
+	{
+		while (!diskTier->CanFit(data.size()) && diskTier->GetOldestKey() != -1)
+		{
+			int32_t oldest = diskTier->GetOldestKey();
+			diskTier->Erase(oldest);
+			ReleaseSlot(oldest);
+		}
+
+		if (diskTier->Insert(slotIndex, data))
+		{
+			slots[slotIndex].tier = SlotTier::DISK;
+			return;
+		}
+	}
+
+	ReleaseSlot(slotIndex);
+}
+
+template <class TState>
+void SlotManager<TState>::Promote(int32_t slotIndex)
+{
+	Slot& slot = slots[slotIndex];
+	if (slot.tier == SlotTier::DISK)
+	{
+		diskTier->Read(slotIndex, _serializeBuffer);
+		diskTier->Erase(slotIndex);
 	}
+	else
+	{
+		compressedTier->Read(slotIndex, _serializeBuffer);
+		compressedTier->Erase(slotIndex);
+	}
+
+	if (!_resource->deserialize(_serializeBuffer, slot.state))
+		throw std::runtime_error("Failed to deserialize slot " + std::to_string(slot.id));
+
+	slot.tier = SlotTier::RAM;
+	slot.size = _resource->getStateSize(slot.state);
+	_slotSaveMem += slot.size;
+	UpdateSaveMem();
+	nSlots++;
+	nPromotions++;
+	PushMostRecent(slotIndex);
+	evictionPolicy->OnCreate(*this, slotIndex);
 }
 
 template <class TState>
 void SlotManager<TState>::LoadSlot(int64_t slotId)
 {
-	int64_t slotOrder = slotLastAccessOrderById[slotId];
-	slotIdsByLastAccess.erase(slotOrder);
+	int32_t slotIndex = GetSlotIndex(slotId);
+	if (slotIndex == -1)
+		throw std::runtime_error("Attempted to load invalid slot " + std::to_string(slotId));
+
+	bool promoted = slots[slotIndex].tier != SlotTier::RAM;
+	if (promoted)
+		Promote(slotIndex);
+	else
+	{
+		//Mark slot as most recently used
+		if (slotIndex != lruTail)
+		{
+			Unlink(slotIndex);
+			PushMostRecent(slotIndex);
+		}
 
-	//NOTE: Order will not overflow on realistic timescales
-	int64_t newSlotOrder = slotIdsByLastAccess.size() == 0 ? 0 : std::prev(slotIdsByLastAccess.end())->first + 1;
-	if (slotIdsByLastAccess.size() != 0 && newSlotOrder == 0)
-		throw std::runtime_error("Max slot touches exceeded.");
+		evictionPolicy->OnLoad(*this, slotIndex);
+	}
 
-	slotIdsByLastAccess[newSlotOrder] = slotId;
-	slotLastAccessOrderById[slotId] = newSlotOrder;
+	nHits++;
 
 	//Load slot memory
-	_resource->load(slotsById[slotId]);
+	_resource->load(slots[slotIndex].state);
+
+	// A promoted slot may have pushed RAM usage over the limit
+	while (promoted && _currentSaveMem > _saveMemLimit && nSlots > 1)
+		EvictSlot();
+}
+
+template <class TState>
+void SlotManager<TState>::EvictSlot()
+{
+	int32_t slotIndex = evictionPolicy->SelectVictim(*this);
+	if (slotIndex == -1)
+		return;
+
+	nEvictions++;
+	if (Demote(slotIndex))
+		return;
+
+	EraseSlot(slots[slotIndex].id);
 }
 
 template <class TState>
 void SlotManager<TState>::EraseOldestSlot()
 {
-	int64_t slotId = slotIdsByLastAccess.begin() == slotIdsByLastAccess.end() ? -1 : slotIdsByLastAccess.begin()->second;
-	if (slotId == -1)
+	if (lruHead == -1)
 		return;
 
-	EraseSlot(slotId);
+	EraseSlot(slots[lruHead].id);
+}
+
+template <class TState>
+int64_t SlotManager<TState>::GetSlotSize(int64_t slotId) const
+{
+	int32_t slotIndex = GetSlotIndex(slotId);
+	return slotIndex == -1 ? 0 : slots[slotIndex].size;
 }
 
 template <class TState>
@@ -119,9 +636,14 @@ int64_t Resource<TState>::SaveState()
 {
 	auto start = get_time();
 	int64_t slotId = slotManager.CreateSlot();
-	_totalSaveStateTime += get_time() - start;
+	uint64_t ticks = get_time() - start;
+	_totalSaveStateTime += ticks;
 
 	nSaveStates++;
+	int64_t size = slotManager.GetSlotSize(slotId);
+	costModel->OnSave(ticks, size);
+	stats[ResourceOperation::SAVE].Record(uint64_t(ticks * _nsPerTick));
+	stats.savedBytes += size;
 
 	return slotId;
 }
@@ -136,52 +658,198 @@ void Resource<TState>::LoadState(int64_t slotId)
 	else
 		slotManager.LoadSlot(slotId);
 
-	_totalLoadStateTime = get_time() - start;
+	uint64_t ticks = get_time() - start;
+	_totalLoadStateTime += ticks;
 
 	nLoadStates++;
+	costModel->OnLoad(ticks);
+	stats[ResourceOperation::LOAD].Record(uint64_t(ticks * _nsPerTick));
+	stats.loadedBytes += slotId == -1 ? getStateSize(startSave) : slotManager.GetSlotSize(slotId);
 }
 
 template <class TState>
+template <class TDerived>
 void Resource<TState>::FrameAdvance()
 {
+	static_assert(std::is_base_of_v<Resource<TState>, TDerived>);
 	auto start = get_time();
 
-	advance();
+	static_cast<TDerived*>(this)->advance();
 
-	_totalFrameAdvanceTime += get_time() - start;
+	uint64_t ticks = get_time() - start;
+	_totalFrameAdvanceTime += ticks;
 	nFrameAdvances++;
+	costModel->OnAdvance(ticks, 1);
+	stats[ResourceOperation::ADVANCE].Record(uint64_t(ticks * _nsPerTick));
 }
 
 template <class TState>
-bool Resource<TState>::shouldSave(int64_t estFrameAdvances) const
+template <class TDerived>
+void Resource<TState>::FrameAdvance(std::span<const Inputs> inputs)
 {
-	if (estFrameAdvances == 0)
-		return false;
+	static_assert(std::is_base_of_v<Resource<TState>, TDerived>);
+	if (inputs.empty())
+		return;
 
-	if (nSaveStates == 0 || nFrameAdvances == 0 || estFrameAdvances < 0)
-		return true;
+	auto start = get_time();
 
-	double estTimeToSave = double(_totalSaveStateTime) / nSaveStates;
-	double estTimeToFrameAdvance =
-		(double(_totalFrameAdvanceTime) / nFrameAdvances) * estFrameAdvances;
+	static_cast<TDerived*>(this)->advanceFrames(inputs);
 
-	return estTimeToSave < estTimeToFrameAdvance;
+	uint64_t ticks = get_time() - start;
+	_totalFrameAdvanceTime += ticks;
+	nFrameAdvances += inputs.size();
+	costModel->OnAdvance(ticks, inputs.size());
+	stats[ResourceOperation::ADVANCE].Record(uint64_t(ticks * _nsPerTick / inputs.size()), inputs.size());
 }
 
 template <class TState>
-bool Resource<TState>::shouldLoad(int64_t framesAhead) const
+void Resource<TState>::SetInputs(Inputs inputs)
 {
-	if (framesAhead == 0)
-		return false;
+	uint8_t* controllerPads = getSymbol<uint8_t>(GameSymbol::gControllerPads);
 
-	if (nLoadStates == 0 || nFrameAdvances == 0 || framesAhead < 0)
-		return true;
+	uint16_t* buttonDllAddr = (uint16_t*)controllerPads;
+	buttonDllAddr[0] = inputs.buttons;
+
+	int8_t* xStickDllAddr = (int8_t*)controllerPads + 2;
+	xStickDllAddr[0] = inputs.stick_x;
 
-	double estTimeToLoad = double(_totalLoadStateTime) / nLoadStates;
-	double estTimeToFrameAdvance =
-		(double(_totalFrameAdvanceTime) / nFrameAdvances) * framesAhead;
+	int8_t* yStickDllAddr = (int8_t*)controllerPads + 3;
+	yStickDllAddr[0] = inputs.stick_y;
+}
 
-	return estTimeToLoad < estTimeToFrameAdvance;
+template <class TState>
+void Resource<TState>::advanceFrames(std::span<const Inputs> inputs)
+{
+	for (const Inputs& frameInputs : inputs)
+	{
+		SetInputs(frameInputs);
+		advance();
+	}
 }
 
-#endif
\ No newline at end of file
+template <class TState>
+double Resource<TState>::getFrameAdvanceTime() const
+{
+	if (nFrameAdvances == 0)
+		return 1;
+
+	return double(_totalFrameAdvanceTime) / nFrameAdvances;
+}
+
+template <class TState>
+Resource<TState>::~Resource()
+{
+	if (statsPath.empty())
+		return;
+
+	try
+	{
+		std::ofstream out(statsPath, std::ios::trunc);
+		out << GetStatsJson() << '\n';
+	}
+	catch (const std::exception&)
+	{
+	}
+}
+
+template <class TState>
+std::string Resource<TState>::GetStatsJson() const
+{
+	std::ostringstream out;
+	out << "{\n\t\"ns_per_tick\": " << _nsPerTick;
+
+	const char* names[] = {"advance", "save", "load"};
+	for (size_t operation = 0; operation < size_t(ResourceOperation::COUNT); operation++)
+	{
+		out << ",\n\t\"" << names[operation] << "\": ";
+		stats.latency[operation].WriteJson(out);
+	}
+
+	out << ",\n\t\"saved_bytes\": " << stats.savedBytes
+		<< ",\n\t\"loaded_bytes\": " << stats.loadedBytes
+		<< ",\n\t\"resimulated_frames\": " << nResimulatedFrames
+		<< ",\n\t\"cost_model\": {\"save_decisions\": " << costModel->nSaveDecisions
+		<< ", \"saves_taken\": " << costModel->nSavesTaken
+		<< ", \"load_decisions\": " << costModel->nLoadDecisions
+		<< ", \"loads_taken\": " << costModel->nLoadsTaken << "}"
+		<< ",\n\t\"slots\": {\"hits\": " << slotManager.nHits
+		<< ", \"misses\": " << slotManager.nMisses
+		<< ", \"evictions\": " << slotManager.nEvictions
+		<< ", \"promotions\": " << slotManager.nPromotions
+		<< ", \"resident\": " << slotManager.nSlots
+		<< ", \"ram_bytes\": " << slotManager._currentSaveMem
+		<< ", \"ram_limit\": " << slotManager._saveMemLimit << "}";
+
+	if (slotManager.compressedTier)
+	{
+		const CompressedSlotStore::Stats& tier = slotManager.compressedTier->GetStats();
+		out << ",\n\t\"compressed_tier\": {\"entries\": " << tier.nEntries
+			<< ", \"raw_bytes\": " << tier.rawBytes
+			<< ", \"stored_bytes\": " << tier.storedBytes
+			<< ", \"mem_limit\": " << slotManager.compressedTier->memLimit
+			<< ", \"inserts\": " << tier.nInserts
+			<< ", \"reads\": " << tier.nReads << "}";
+	}
+
+	if (slotManager.diskTier)
+	{
+		DiskSlotStore::Stats tier = slotManager.diskTier->GetStats();
+		out << ",\n\t\"disk_tier\": {\"entries\": " << tier.nEntries
+			<< ", \"used_bytes\": " << tier.usedBytes
+			<< ", \"capacity\": " << slotManager.diskTier->GetCapacity()
+			<< ", \"inserts\": " << tier.nInserts
+			<< ", \"reads\": " << tier.nReads << "}";
+	}
+
+	out << "\n}";
+	return out.str();
+}
+
+template <class TState>
+void Resource<TState>::EnablePersistentCache(const std::filesystem::path& directory)
+{
+	uint64_t key = getPersistentKey();
+	if (key == 0)
+		throw std::runtime_error("Resource does not support persistent savestates.");
+
+	persistentCache = std::make_unique<PersistentSaveCache>(directory, key);
+}
+
+template <class TState>
+void Resource<TState>::ResolveSymbols()
+{
+	for (size_t i = 0; i < _symbols.size(); i++)
+	{
+		try
+		{
+			_symbols[i] = addr(GameSymbolNames[i]);
+		}
+		catch (const std::exception&)
+		{
+			_symbols[i] = nullptr;
+		}
+	}
+}
+
+template <class TState>
+bool Resource<TState>::shouldSave(int64_t estFrameAdvances) const
+{
+	return costModel->ShouldSave(*this, estFrameAdvances);
+}
+
+template <class TState>
+bool Resource<TState>::shouldLoad(int64_t framesAhead) const
+{
+	return costModel->ShouldLoad(*this, framesAhead);
+}
+
+template <class TState>
+void Resource<TState>::SetCostModel(std::unique_ptr<SaveCostModel<TState>> model)
+{
+	if (!model)
+		throw std::runtime_error("Cost model must not be null.");
+
+	costModel = std::move(model);
+}
+
+#endif
@@ -0,0 +1,75 @@
+#pragma once
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <ostream>
+
+#ifndef RESOURCESTATS_H
+#define RESOURCESTATS_H
+
+// Latency distribution in nanoseconds. Each power of two is split into 8
+// linear buckets, so a quantile is at most 1/8 above the true value.
+class LatencyHistogram
+{
+public:
+	uint64_t count = 0;
+	uint64_t totalNs = 0;
+	uint64_t maxNs = 0;
+
+	// weight records the same latency that many times, e.g. per frame of a batch
+	void Record(uint64_t ns, uint64_t weight = 1)
+	{
+		_buckets[GetBucket(ns)] += weight;
+		count += weight;
+		totalNs += ns * weight;
+		if (ns > maxNs)
+			maxNs = ns;
+	}
+
+	// Upper bound of the bucket holding the q-th sample, 0 if there are none
+	uint64_t Quantile(double q) const;
+	double MeanNs() const { return count ? double(totalNs) / count : 0; }
+	void WriteJson(std::ostream& out) const;
+
+private:
+	static constexpr int SUB_BUCKET_BITS = 3;
+	static constexpr size_t N_BUCKETS = (64 - SUB_BUCKET_BITS + 1) << SUB_BUCKET_BITS;
+
+	std::array<uint64_t, N_BUCKETS> _buckets = {};
+
+	static size_t GetBucket(uint64_t ns)
+	{
+		if (ns < (1u << SUB_BUCKET_BITS))
+			return size_t(ns);
+
+		int shift = std::bit_width(ns) - 1 - SUB_BUCKET_BITS;
+		return (size_t(shift + 1) << SUB_BUCKET_BITS) + size_t((ns >> shift) & ((1u << SUB_BUCKET_BITS) - 1));
+	}
+
+	static uint64_t GetBucketUpperBound(size_t bucket);
+};
+
+enum class ResourceOperation : uint8_t
+{
+	ADVANCE, // per frame, also for batches
+	SAVE,
+	LOAD,
+	COUNT
+};
+
+class ResourceStats
+{
+public:
+	std::array<LatencyHistogram, size_t(ResourceOperation::COUNT)> latency;
+	uint64_t savedBytes = 0; // state size of every slot created
+	uint64_t loadedBytes = 0; // state size of every slot loaded
+
+	LatencyHistogram& operator[](ResourceOperation operation) { return latency[size_t(operation)]; }
+	const LatencyHistogram& operator[](ResourceOperation operation) const { return latency[size_t(operation)]; }
+};
+
+// Nanoseconds per get_time() tick, measured once per process against
+// steady_clock. Returns 1 if ticks aren't TSC cycles.
+double GetNanosecondsPerTick();
+
+#endif
@@ -0,0 +1,69 @@
+#pragma once
+#include <cstdint>
+#include <set>
+#include <vector>
+
+#ifndef SAVEINDEX_H
+#define SAVEINDEX_H
+
+// Savestates of a whole script tree, ordered by frame. Running scripts and
+// their ad-hoc levels form a stack of positions, the root at depth 0. A save
+// is hidden while a position above its own has a diff starting before it,
+// so the latest usable save is a single ordered lookup.
+template <class TOwner>
+class SaveIndex
+{
+public:
+	struct Save
+	{
+		TOwner* owner = nullptr; // nullptr if no save was found
+		int64_t adhocLevel = -1;
+		int64_t frame = -1;
+	};
+
+	int64_t Depth() const { return int64_t(_positions.size()) - 1; }
+	TOwner* GetOwner(int64_t depth) const { return _positions[depth].owner; }
+
+	void Push(TOwner* owner, int64_t adhocLevel);
+
+	// The top position's saves must have been erased first
+	void Pop();
+
+	// First frame of the top position's diff, INT64_MAX if it is empty
+	void SetBound(int64_t bound);
+
+	void Insert(int64_t depth, int64_t frame);
+	void Erase(int64_t depth, int64_t frame);
+
+	// Latest visible save at or before frame
+	Save FindLatest(int64_t frame) const;
+
+private:
+	struct Key
+	{
+		int64_t frame;
+		int64_t depth;
+
+		// On a shared frame the lowest position sorts last, as it outlives the others
+		bool operator<(const Key& other) const
+		{
+			return frame != other.frame ? frame < other.frame : depth > other.depth;
+		}
+	};
+
+	struct Position
+	{
+		TOwner* owner = nullptr;
+		int64_t adhocLevel = 0;
+		int64_t bound = INT64_MAX;
+		std::set<Key> hidden; // saves below this position after bound, and visible without it
+	};
+
+	std::set<Key> _visible;
+	std::vector<Position> _positions;
+};
+
+//Include template method implementations
+#include "tasfw/SaveIndex.t.hpp"
+
+#endif
@@ -0,0 +1,94 @@
+#pragma once
+#ifndef SAVEINDEX_H
+#error "SaveIndex.t.hpp should only be included by SaveIndex.hpp"
+#else
+
+#include <iterator>
+
+template <class TOwner>
+void SaveIndex<TOwner>::Push(TOwner* owner, int64_t adhocLevel)
+{
+	_positions.push_back(Position{ owner, adhocLevel, INT64_MAX, {} });
+}
+
+template <class TOwner>
+void SaveIndex<TOwner>::Pop()
+{
+	_visible.merge(_positions.back().hidden);
+	_positions.pop_back();
+}
+
+template <class TOwner>
+void SaveIndex<TOwner>::SetBound(int64_t bound)
+{
+	Position& top = _positions.back();
+	int64_t depth = Depth();
+
+	if (bound < top.bound)
+	{
+		//Lower positions' saves after the new bound are desynced by the diff
+		auto it = _visible.lower_bound(Key{ bound + 1, INT64_MAX });
+		while (it != _visible.end() && it->frame <= top.bound)
+		{
+			auto next = std::next(it);
+			if (it->depth < depth)
+				top.hidden.insert(_visible.extract(it));
+			it = next;
+		}
+	}
+	else if (bound > top.bound)
+	{
+		//Saves up to the new bound are in sync again
+		auto end = bound == INT64_MAX ? top.hidden.end() : top.hidden.lower_bound(Key{ bound + 1, INT64_MAX });
+		while (top.hidden.begin() != end)
+			_visible.insert(top.hidden.extract(top.hidden.begin()));
+	}
+
+	top.bound = bound;
+}
+
+template <class TOwner>
+void SaveIndex<TOwner>::Insert(int64_t depth, int64_t frame)
+{
+	//Hide behind the lowest position desyncing it, the last one to be popped
+	Key key{ frame, depth };
+	for (int64_t i = depth + 1; i <= Depth(); i++)
+	{
+		if (_positions[i].bound < frame)
+		{
+			_positions[i].hidden.insert(key);
+			return;
+		}
+	}
+
+	_visible.insert(key);
+}
+
+template <class TOwner>
+void SaveIndex<TOwner>::Erase(int64_t depth, int64_t frame)
+{
+	Key key{ frame, depth };
+	if (_visible.erase(key))
+		return;
+
+	for (int64_t i = depth + 1; i <= Depth(); i++)
+	{
+		if (_positions[i].hidden.erase(key))
+			return;
+	}
+}
+
+template <class TOwner>
+typename SaveIndex<TOwner>::Save SaveIndex<TOwner>::FindLatest(int64_t frame) const
+{
+	//Every key on frame sorts before this one
+	auto it = _visible.upper_bound(Key{ frame, INT64_MIN });
+	if (it == _visible.begin())
+		return Save();
+
+	--it;
+	const Position& position = _positions[it->depth];
+	return Save{ position.owner, position.adhocLevel, it->frame };
+}
+
+#endif
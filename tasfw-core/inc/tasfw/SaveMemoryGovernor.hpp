@@ -0,0 +1,63 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#ifndef SAVEMEMORYGOVERNOR_H
+#define SAVEMEMORYGOVERNOR_H
+
+// Splits one savestate budget between the slot managers of many resources,
+// e.g. one per scattershot thread. Every share keeps at least half of an
+// equal split; the other half follows recent miss rates, so threads that keep
+// losing slots they come back to get more memory.
+class SaveMemoryGovernor
+{
+public:
+	// Written by the governor, read by the owning slot manager. Counters are
+	// the manager's lifetime totals, published before every read.
+	class Share
+	{
+	public:
+		std::atomic<int64_t> limit = 0;
+		std::atomic<uint64_t> nHits = 0;
+		std::atomic<uint64_t> nMisses = 0;
+
+		// Publishes the counters and returns the current limit
+		int64_t Report(uint64_t hits, uint64_t misses);
+
+	private:
+		friend class SaveMemoryGovernor;
+
+		SaveMemoryGovernor* _governor = nullptr;
+		uint64_t _lastHits = 0;
+		uint64_t _lastMisses = 0;
+		double _weight = 1;
+	};
+
+	uint64_t rebalanceInterval = 4096; // reports between rebalances, across all shares
+	int64_t minShare = 64 * 1024 * 1024; // no share is squeezed below this
+
+	// Shared by every resource in the process
+	static SaveMemoryGovernor& Global();
+
+	// 0 derives the budget from available system memory
+	void SetBudget(int64_t budget);
+	int64_t GetBudget() const { return _budget.load(std::memory_order_relaxed); }
+	std::shared_ptr<Share> Register();
+	void Rebalance();
+
+	// Physical memory currently available to the process, 0 if unknown
+	static int64_t GetAvailableMemory();
+
+private:
+	std::mutex _mutex;
+	std::vector<std::shared_ptr<Share>> _shares; // dropped once only the governor holds them
+	std::atomic<int64_t> _budget = 0;
+	std::atomic<uint64_t> _nReports = 0;
+
+	void RebalanceLocked();
+};
+
+#endif
@@ -1,10 +1,11 @@
 #pragma once
-#include <unordered_map>
+#include <utility>
 #include <tasfw/Resource.hpp>
 #include <tasfw/Inputs.hpp>
 #include <sm64/Types.hpp>
 #include <tasfw/ScriptStatus.hpp>
-#include <set>
+#include <tasfw/FrameMap.hpp>
+#include <tasfw/SaveIndex.hpp>
 #include <tasfw/SharedLib.hpp>
 #include <tasfw/ScriptCompareHelper.hpp>
 
@@ -26,8 +27,9 @@ public:
 
 	SlotHandle(TResource* resource, int64_t slotId) : resource(resource), slotId(slotId) { }
 
-	SlotHandle(SlotHandle<TResource>&&) = default;
-	SlotHandle<TResource>& operator = (SlotHandle<TResource>&&) = default;
+	// Moves transfer ownership, so only the destination erases the slot
+	SlotHandle(SlotHandle<TResource>&& other) noexcept : resource(other.resource), slotId(std::exchange(other.slotId, -1)) { }
+	SlotHandle<TResource>& operator = (SlotHandle<TResource>&& other) noexcept;
 
 	SlotHandle(const SlotHandle<TResource>&) = delete;
 	SlotHandle<TResource>& operator= (const SlotHandle<TResource>&) = delete;
@@ -35,6 +37,8 @@ public:
 	~SlotHandle();
 
 	bool isValid();
+	// isValid() for a save about to be loaded, see SlotManager::PrepareLoad()
+	bool prepareLoad();
 };
 
 template <derived_from_specialization_of<Resource> TResource>
@@ -553,6 +557,8 @@ protected:
 	void Apply(const M64Diff& m64Diff);
 	void AdvanceFrameRead();
 	void AdvanceFrameWrite(Inputs inputs);
+	void AdvanceFramesRead(int64_t nFrames);
+	void AdvanceFramesWrite(std::span<const Inputs> inputs);
 	void OptionalSave();
 	void Save();
 	void Load(uint64_t frame);
@@ -577,31 +583,42 @@ private:
 
 	int64_t _adhocLevel = 0;
 	int32_t _initialFrame = 0;
-	std::unordered_map<int64_t, BaseScriptStatus> BaseStatus;
-	std::unordered_map<int64_t, std::map<int64_t, SlotHandle<TResource>>> saveBank;// contains handles to savestates
-	std::unordered_map<int64_t, std::map<int64_t, uint64_t>> frameCounter;// tracks opportunity cost of having to frame advance from an earlier save
-	std::unordered_map<int64_t, std::map<int64_t, SaveMetadata<TResource>>> saveCache;// stores metadata of ancestor saves to save recursion time
-	std::unordered_map<int64_t, std::map<int64_t, InputsMetadata<TResource>>> inputsCache;// caches ancestor inputs to save recursion time
-	std::unordered_map<int64_t, std::set<int64_t>> loadTracker;// track past loads to know whether a cached save is optimal
+	// Indexed by adhoc level. Levels above _adhocLevel are left empty but keep
+	// their capacity, so entering an adhoc script doesn't allocate.
+	std::vector<BaseScriptStatus> BaseStatus = std::vector<BaseScriptStatus>(1);
+	std::vector<FrameMap<SlotHandle<TResource>>> saveBank = std::vector<FrameMap<SlotHandle<TResource>>>(1);// contains handles to savestates
+	std::vector<FrameMap<uint64_t>> frameCounter = std::vector<FrameMap<uint64_t>>(1);// tracks opportunity cost of having to frame advance from an earlier save
+	std::vector<FrameMap<InputsMetadata<TResource>>> inputsCache = std::vector<FrameMap<InputsMetadata<TResource>>>(1);// effective inputs and state owners, erased from the first written frame on
+	std::vector<FrameMap<uint64_t>> inputPrefixHashes = std::vector<FrameMap<uint64_t>>(1);// hashes of the inputs before a frame, kept at persistent save lookups
 	Script* _parentScript;
+	SaveIndex<Script<TResource>>* _saveIndex = nullptr;// shared by the whole script tree
+	int64_t _saveDepth = 0;// position of ad-hoc level 0 in _saveIndex
+	std::vector<Inputs> _inputsBuffer;// inputs of a replay batch, reused between batches
 	ScriptCompareHelper<TResource> compareHelper = ScriptCompareHelper<TResource>(this);
 
 	bool Run();
 
 	void Initialize(Script<TResource>* parentScript);
 	SaveMetadata<TResource> GetLatestSave(int64_t frame);
-	SaveMetadata<TResource> GetLatestSaveAndCache(int64_t frame);
-	virtual InputsMetadata<TResource> GetInputsMetadata(int64_t frame);
-	InputsMetadata<TResource> GetInputsMetadataAndCache(int64_t frame);
+	InputsMetadata<TResource> GetInputsMetadata(int64_t frame);
+	virtual InputsMetadata<TResource> ResolveInputsMetadata(int64_t frame);
 	void DeleteSave(int64_t frame, int64_t adhocLevel);
+	void EraseFrameData(int64_t frame);
+	void PopSaveBank(FrameMap<SlotHandle<TResource>>& childSaveBank, int64_t lastSyncedFrame);
 	void SetInputs(Inputs inputs);
-	void Revert(uint64_t frame, const M64Diff& m64, std::map<int64_t, SlotHandle<TResource>>& childSaveBank);
+	void AdvanceFrames(std::span<const Inputs> inputs);
+	void Revert(uint64_t frame, const M64Diff& m64, FrameMap<SlotHandle<TResource>>& childSaveBank);
 	void AdvanceFrameRead(uint64_t& counter);
 	uint64_t GetFrameCounter(InputsMetadata<TResource> cachedInputs);
 	uint64_t IncrementFrameCounter(InputsMetadata<TResource> cachedInputs);
-	void ApplyChildDiff(const BaseScriptStatus& status, std::map<int64_t, SlotHandle<TResource>>& childSaveBank, int64_t initialFrame);
+	void ApplyChildDiff(const BaseScriptStatus& status, FrameMap<SlotHandle<TResource>>& childSaveBank, int64_t initialFrame);
 	SaveMetadata<TResource> Save(int64_t adhocLevel);
 	void LoadBase(uint64_t frame, bool desync);
+	static uint64_t HashInputs(uint64_t hash, Inputs inputs);
+	int64_t FindInputPrefixHash(int64_t frame, uint64_t& hash);
+	uint64_t GetInputPrefixHash(int64_t frame);
+	bool LoadPersistentSave(int64_t minFrame, int64_t frame);
+	void StorePersistentSave(int64_t nResimulatedFrames);
 
 	template <typename F>
 	BaseScriptStatus ExecuteAdhocBase(F adhocScript);
@@ -619,17 +636,19 @@ public:
 	{
 		TTopLevelScript script = TTopLevelScript(std::forward<Ts>(params)...);
 		TResource resource = TResource();
+		SaveIndex<Script<TResource>> saveIndex;
 		resource.save(resource.startSave);
 		resource.initialFrame = 0;
 
 		script._m64 = &m64;
 		script.resource = &resource;
+		script._saveIndex = &saveIndex;
 		script.Initialize(nullptr);
 
 		script.Run();
 
 		//Dispose of slot handles before resource goes out of scope because they trigger destructor events in the resource.
-		script.saveBank[0].erase(script.saveBank[0].begin(), script.saveBank[0].end());
+		script.saveBank[0].Clear();
 
 		return ScriptStatus<TTopLevelScript>(script.BaseStatus[0], script.CustomStatus);		
 	}
@@ -640,17 +659,19 @@ public:
 	{
 		TTopLevelScript script = TTopLevelScript(std::forward<Ts>(params)...);
 		TResource resource = TResource(config);
+		SaveIndex<Script<TResource>> saveIndex;
 		resource.save(resource.startSave);
 		resource.initialFrame = 0;
 
 		script._m64 = &m64;
 		script.resource = &resource;
+		script._saveIndex = &saveIndex;
 		script.Initialize(nullptr);
 
 		script.Run();
 
 		//Dispose of slot handles before resource goes out of scope because they trigger destructor events in the resource.
-		script.saveBank[0].erase(script.saveBank[0].begin(), script.saveBank[0].end());
+		script.saveBank[0].Clear();
 
 		return ScriptStatus<TTopLevelScript>(script.BaseStatus[0], script.CustomStatus);
 	}
@@ -663,18 +684,21 @@ public:
 	{
 		TTopLevelScript script = TTopLevelScript(std::forward<Ts>(params)...);
 		TResource resource = TResource();
+		SaveIndex<Script<TResource>> saveIndex;
 		resource.load(save.state);
 		resource.save(resource.startSave);
 		resource.initialFrame = save.initialFrame;
+		resource.persistentCache.reset(); // cached states assume a power-on start
 
 		script._m64 = &m64;
 		script.resource = &resource;
+		script._saveIndex = &saveIndex;
 		script.Initialize(nullptr);
 
 		script.Run();
 
 		//Dispose of slot handles before resource goes out of scope because they trigger destructor events in the resource.
-		script.saveBank[0].erase(script.saveBank[0].begin(), script.saveBank[0].end());
+		script.saveBank[0].Clear();
 
 		return ScriptStatus<TTopLevelScript>(script.BaseStatus[0], script.CustomStatus);
 	}
@@ -687,18 +711,21 @@ public:
 	{
 		TTopLevelScript script = TTopLevelScript(std::forward<Ts>(params)...);
 		TResource resource = TResource(config);
+		SaveIndex<Script<TResource>> saveIndex;
 		resource.load(save.state);
 		resource.save(resource.startSave);
 		resource.initialFrame = save.initialFrame;
+		resource.persistentCache.reset(); // cached states assume a power-on start
 
 		script._m64 = &m64;
 		script.resource = &resource;
+		script._saveIndex = &saveIndex;
 		script.Initialize(nullptr);
 
 		script.Run();
 
 		//Dispose of slot handles before resource goes out of scope because they trigger destructor events in the resource.
-		script.saveBank[0].erase(script.saveBank[0].begin(), script.saveBank[0].end());
+		script.saveBank[0].Clear();
 
 		return ScriptStatus<TTopLevelScript>(script.BaseStatus[0], script.CustomStatus);
 	}
@@ -711,7 +738,7 @@ protected:
 	M64* _m64 = nullptr;
 
 private:
-	InputsMetadata<TResource> GetInputsMetadata(int64_t frame) override;
+	InputsMetadata<TResource> ResolveInputsMetadata(int64_t frame) override;
 };
 
 //Include template method implementations
@@ -12,6 +12,21 @@ SlotHandle<TResource>::~SlotHandle()
 		resource->slotManager.EraseSlot(slotId);
 }
 
+template <derived_from_specialization_of<Resource> TResource>
+SlotHandle<TResource>& SlotHandle<TResource>::operator = (SlotHandle<TResource>&& other) noexcept
+{
+	if (this != &other)
+	{
+		if (slotId != -1)
+			resource->slotManager.EraseSlot(slotId);
+
+		resource = other.resource;
+		slotId = std::exchange(other.slotId, -1);
+	}
+
+	return *this;
+}
+
 template <derived_from_specialization_of<Resource> TResource>
 bool SlotHandle<TResource>::isValid()
 {
@@ -22,20 +37,29 @@ bool SlotHandle<TResource>::isValid()
 	return resource->slotManager.isValid(slotId);
 }
 
+template <derived_from_specialization_of<Resource> TResource>
+bool SlotHandle<TResource>::prepareLoad()
+{
+	//Start save handle is always valid
+	if (resource && slotId == -1)
+		return true;
+
+	return resource->slotManager.PrepareLoad(slotId);
+}
+
 template <derived_from_specialization_of<Resource> TResource>
 void Script<TResource>::Initialize(Script<TResource>* parentScript)
 {
 	_parentScript = parentScript;
 
-	BaseStatus[0];
-	saveBank[0];
-	frameCounter[0];
-	saveCache[0];
-	inputsCache[0];
-	loadTracker[0];
-
 	if (_parentScript)
+	{
 		resource = _parentScript->resource;
+		_saveIndex = _parentScript->_saveIndex;
+	}
+
+	_saveDepth = _saveIndex->Depth() + 1;
+	_saveIndex->Push(this, 0);
 
 	startSaveHandle = SlotHandle<TResource>(resource, -1);
 	_initialFrame = GetCurrentFrame();
@@ -91,8 +115,8 @@ uint64_t Script<TResource>::GetCurrentFrame()
 template <derived_from_specialization_of<Resource> TResource>
 void Script<TResource>::AdvanceFrameRead()
 {
-	SetInputs(GetInputsMetadataAndCache(GetCurrentFrame()).inputs);
-	resource->FrameAdvance();
+	SetInputs(GetInputsMetadata(GetCurrentFrame()).inputs);
+	resource->template FrameAdvance<TResource>();
 	BaseStatus[_adhocLevel].nFrameAdvances++;
 }
 
@@ -101,58 +125,82 @@ void Script<TResource>::AdvanceFrameWrite(Inputs inputs)
 {
 	// Save inputs to diff
 	uint64_t currentFrame = GetCurrentFrame();
-	BaseStatus[_adhocLevel].m64Diff.frames[currentFrame] = inputs;
+	BaseStatus[_adhocLevel].m64Diff.frames.Set(currentFrame, inputs);
 
-	// Erase all saves, cached saves and inputs, tracked loads and frame counters after this point, as well as the cached input on this frame
-	inputsCache[_adhocLevel].erase(inputsCache[_adhocLevel].lower_bound(currentFrame), inputsCache[_adhocLevel].end());
-	frameCounter[_adhocLevel].erase(frameCounter[_adhocLevel].upper_bound(currentFrame), frameCounter[_adhocLevel].end());
-	saveBank[_adhocLevel].erase(saveBank[_adhocLevel].upper_bound(currentFrame), saveBank[_adhocLevel].end());
-	saveCache[_adhocLevel].erase(saveCache[_adhocLevel].upper_bound(currentFrame), saveCache[_adhocLevel].end());
+	// Erase all saves, cached inputs and frame counters after this point, as well as the cached input on this frame
+	EraseFrameData(currentFrame);
 
 	// Set inputs and advance frame
 	SetInputs(inputs);
-	resource->FrameAdvance();
+	resource->template FrameAdvance<TResource>();
 	BaseStatus[_adhocLevel].nFrameAdvances++;
 }
 
+// Same as calling AdvanceFrameRead nFrames times
+template <derived_from_specialization_of<Resource> TResource>
+void Script<TResource>::AdvanceFramesRead(int64_t nFrames)
+{
+	if (nFrames <= 0)
+		return;
+
+	int64_t currentFrame = GetCurrentFrame();
+
+	_inputsBuffer.clear();
+	for (int64_t frame = currentFrame; frame < currentFrame + nFrames; frame++)
+		_inputsBuffer.push_back(GetInputsMetadata(frame).inputs);
+
+	AdvanceFrames(_inputsBuffer);
+}
+
+// Same as calling AdvanceFrameWrite for each entry, but the diff is written
+// and the later saves and caches are erased once for the whole span
+template <derived_from_specialization_of<Resource> TResource>
+void Script<TResource>::AdvanceFramesWrite(std::span<const Inputs> inputs)
+{
+	if (inputs.empty())
+		return;
+
+	uint64_t currentFrame = GetCurrentFrame();
+	BaseStatus[_adhocLevel].m64Diff.frames.SetRange(currentFrame, inputs);
+
+	EraseFrameData(currentFrame);
+
+	AdvanceFrames(inputs);
+}
+
+template <derived_from_specialization_of<Resource> TResource>
+void Script<TResource>::AdvanceFrames(std::span<const Inputs> inputs)
+{
+	resource->template FrameAdvance<TResource>(inputs);
+	BaseStatus[_adhocLevel].nFrameAdvances += inputs.size();
+}
+
 template <derived_from_specialization_of<Resource> TResource>
 void Script<TResource>::Apply(const M64Diff& m64Diff)
 {
-	if (m64Diff.frames.empty())
+	if (m64Diff.frames.Empty())
 		return;
 
-	uint64_t firstFrame = m64Diff.frames.begin()->first;
-	uint64_t lastFrame = m64Diff.frames.rbegin()->first;
+	uint64_t firstFrame = m64Diff.frames.First();
+	uint64_t lastFrame = m64Diff.frames.Last();
 
 	Load(firstFrame);
 
-	// Erase all saves, cached saves, and frame counters after this point
+	// Write the diff, then erase all saves, cached inputs and frame counters
+	// after this point. Frames the diff doesn't override keep their inputs.
 	uint64_t currentFrame = GetCurrentFrame();
-	inputsCache[_adhocLevel].erase(inputsCache[_adhocLevel].lower_bound(currentFrame), inputsCache[_adhocLevel].end());
-	frameCounter[_adhocLevel].erase(frameCounter[_adhocLevel].upper_bound(currentFrame), frameCounter[_adhocLevel].end());
-	saveBank[_adhocLevel].erase(saveBank[_adhocLevel].upper_bound(currentFrame), saveBank[_adhocLevel].end());
-	saveCache[_adhocLevel].erase(saveCache[_adhocLevel].upper_bound(currentFrame), saveCache[_adhocLevel].end());
-
-	while (currentFrame <= lastFrame)
-	{
-		// Use default inputs if diff doesn't override them
-		auto inputs = GetInputs(currentFrame);
-		if (m64Diff.frames.contains(currentFrame))
-		{
-			inputs = m64Diff.frames.at(currentFrame);
-			BaseStatus[_adhocLevel].m64Diff.frames[currentFrame] = inputs;
-		}
+	BaseStatus[_adhocLevel].m64Diff.frames.Merge(m64Diff.frames);
+	EraseFrameData(currentFrame);
 
-		SetInputs(inputs);
-		resource->FrameAdvance();
-		BaseStatus[_adhocLevel].nFrameAdvances++;
+	_inputsBuffer.clear();
+	for (uint64_t frame = currentFrame; frame <= lastFrame; frame++)
+		_inputsBuffer.push_back(GetInputs(frame));
 
-		currentFrame = GetCurrentFrame();
-	}
+	AdvanceFrames(_inputsBuffer);
 }
 
 template <derived_from_specialization_of<Resource> TResource>
-void Script<TResource>::ApplyChildDiff(const BaseScriptStatus& status, std::map<int64_t, SlotHandle<TResource>>& childSaveBank, int64_t initialFrame)
+void Script<TResource>::ApplyChildDiff(const BaseScriptStatus& status, FrameMap<SlotHandle<TResource>>& childSaveBank, int64_t initialFrame)
 {
 	//Revert if script was unsuccessful
 	if (!status.asserted)
@@ -162,29 +210,18 @@ void Script<TResource>::ApplyChildDiff(const BaseScriptStatus& status, std::map<
 	}	
 
 	//Move child saves to parent because they are still synced
-	//If child is ad-hoc script, pop the save bank
-	std::move(childSaveBank.begin(), childSaveBank.end(), std::insert_iterator(saveBank[_adhocLevel], saveBank[_adhocLevel].end()));
-	if (saveBank.contains(_adhocLevel + 1))
-		saveBank.erase(_adhocLevel + 1);
+	PopSaveBank(childSaveBank, INT64_MAX);
 
-	if (!status.m64Diff.frames.empty())
+	if (!status.m64Diff.frames.Empty())
 	{
-		uint64_t firstFrame = status.m64Diff.frames.begin()->first;
-		uint64_t lastFrame = status.m64Diff.frames.rbegin()->first;
-
-		// Erase all saves, cached saves, and frame counters after this point
-		inputsCache[_adhocLevel].erase(inputsCache[_adhocLevel].lower_bound(firstFrame), inputsCache[_adhocLevel].end());
-		frameCounter[_adhocLevel].erase(frameCounter[_adhocLevel].upper_bound(firstFrame), frameCounter[_adhocLevel].end());
-		saveBank[_adhocLevel].erase(saveBank[_adhocLevel].upper_bound(firstFrame), saveBank[_adhocLevel].end());
-		saveCache[_adhocLevel].erase(saveCache[_adhocLevel].upper_bound(firstFrame), saveCache[_adhocLevel].end());
+		uint64_t firstFrame = status.m64Diff.frames.First();
+		uint64_t lastFrame = status.m64Diff.frames.Last();
 
 		//Apply diff. State is already synced from child script, so no need to update it
-		
-		for (uint64_t frame = firstFrame; frame <= lastFrame; frame++)
-		{
-			if (status.m64Diff.frames.count(frame))
-				BaseStatus[_adhocLevel].m64Diff.frames[frame] = status.m64Diff.frames.at(frame);
-		}
+		BaseStatus[_adhocLevel].m64Diff.frames.Merge(status.m64Diff.frames);
+
+		// Erase all saves, cached inputs, and frame counters after this point
+		EraseFrameData(firstFrame);
 
 		//Forward state to end of diff
 		Load(lastFrame + 1);
@@ -197,7 +234,7 @@ void Script<TResource>::ApplyChildDiff(const BaseScriptStatus& status, std::map<
 template <derived_from_specialization_of<Resource> TResource>
 Inputs Script<TResource>::GetInputs(int64_t frame)
 {
-	return GetInputsMetadataAndCache(frame).inputs;
+	return GetInputsMetadata(frame).inputs;
 }
 
 template <derived_from_specialization_of<Resource> TResource>
@@ -205,7 +242,7 @@ M64Diff Script<TResource>::GetInputs(int64_t firstFrame, int64_t lastFrame)
 {
 	M64Diff diff;
 	for (int64_t frame = firstFrame; frame <= lastFrame; frame++)
-		diff.frames[frame] = GetInputsMetadata(frame).inputs;
+		diff.frames.Set(frame, GetInputsMetadata(frame).inputs);
 
 	return diff;
 }
@@ -225,14 +262,28 @@ bool Script<TResource>::ExportM64(std::filesystem::path fileName, int64_t maxFra
 	M64 outM64 = M64(fileName);
 	for (int64_t frame = 0; frame < maxFrame; frame++)
 	{
-		outM64.frames[frame] = GetInputsMetadata(frame).inputs;
+		outM64.frames.Set(frame, GetInputsMetadata(frame).inputs);
 	}
 
 	return (bool)outM64.save();
 }
 
+// Resolved once per frame and level, then a single lookup until a write at or
+// before the frame erases it
 template <derived_from_specialization_of<Resource> TResource>
 InputsMetadata<TResource> Script<TResource>::GetInputsMetadata(int64_t frame)
+{
+	FrameMap<InputsMetadata<TResource>>& cache = inputsCache[_adhocLevel];
+	if (InputsMetadata<TResource>* cached = cache.Find(frame))
+		return *cached;
+
+	InputsMetadata<TResource> metadata = ResolveInputsMetadata(frame);
+	cache[frame] = metadata;
+	return metadata;
+}
+
+template <derived_from_specialization_of<Resource> TResource>
+InputsMetadata<TResource> Script<TResource>::ResolveInputsMetadata(int64_t frame)
 {
 	if (!_parentScript)
 		throw std::runtime_error("Failed to get inputs because of missing parent script");
@@ -248,29 +299,29 @@ InputsMetadata<TResource> Script<TResource>::GetInputsMetadata(int64_t frame)
 	{
 		if (!stateOwner)
 		{
-			if (!BaseStatus[adhocLevel].m64Diff.frames.empty() && static_cast<int64_t>(BaseStatus[adhocLevel].m64Diff.frames.begin()->first) < frame)
+			if (!BaseStatus[adhocLevel].m64Diff.frames.Empty() && BaseStatus[adhocLevel].m64Diff.frames.First() < frame)
 			{
 				stateOwner = this;
 				stateOwnerAdhocLevel = adhocLevel;
 			}
 		}
 
-		if (BaseStatus[adhocLevel].m64Diff.frames.contains(frame))
+		if (const Inputs* diffInputs = BaseStatus[adhocLevel].m64Diff.frames.Find(frame))
 		{
 			if (stateOwner)
-				return InputsMetadata<TResource>(replaceInputs ? inputs : BaseStatus[adhocLevel].m64Diff.frames[frame], frame, stateOwner, stateOwnerAdhocLevel);
+				return InputsMetadata<TResource>(replaceInputs ? inputs : *diffInputs, frame, stateOwner, stateOwnerAdhocLevel);
 
 			if (!replaceInputs)
 			{
 				replaceInputs = true;
-				inputs = BaseStatus[adhocLevel].m64Diff.frames[frame];
+				inputs = *diffInputs;
 			}
 		}
 			
 
-		if (inputsCache[adhocLevel].contains(frame))
+		if (InputsMetadata<TResource>* cached = inputsCache[adhocLevel].Find(frame))
 		{
-			InputsMetadata<TResource> metadata = inputsCache[adhocLevel][frame];
+			InputsMetadata<TResource> metadata = *cached;
 			if (stateOwner)
 			{
 				metadata.stateOwner = stateOwner;
@@ -302,7 +353,7 @@ InputsMetadata<TResource> Script<TResource>::GetInputsMetadata(int64_t frame)
 }
 
 template <derived_from_specialization_of<Resource> TResource>
-InputsMetadata<TResource> TopLevelScript<TResource>::GetInputsMetadata(int64_t frame)
+InputsMetadata<TResource> TopLevelScript<TResource>::ResolveInputsMetadata(int64_t frame)
 {
 	//State owner determines what frame counter needs to be incremented
 	int64_t stateOwnerAdhocLevel = -1;
@@ -314,25 +365,25 @@ InputsMetadata<TResource> TopLevelScript<TResource>::GetInputsMetadata(int64_t f
 	{
 		if (stateOwnerAdhocLevel == -1)
 		{
-			if (!this->BaseStatus[adhocLevel].m64Diff.frames.empty() && static_cast<int64_t>(this->BaseStatus[adhocLevel].m64Diff.frames.begin()->first) < frame)
+			if (!this->BaseStatus[adhocLevel].m64Diff.frames.Empty() && this->BaseStatus[adhocLevel].m64Diff.frames.First() < frame)
 				stateOwnerAdhocLevel = adhocLevel;
 		}
 
-		if (this->BaseStatus[adhocLevel].m64Diff.frames.contains(frame))
+		if (const Inputs* diffInputs = this->BaseStatus[adhocLevel].m64Diff.frames.Find(frame))
 		{
 			if (stateOwnerAdhocLevel != -1)
-				return InputsMetadata<TResource>(replaceInputs ? inputs : this->BaseStatus[adhocLevel].m64Diff.frames[frame], frame, this, stateOwnerAdhocLevel);
+				return InputsMetadata<TResource>(replaceInputs ? inputs : *diffInputs, frame, this, stateOwnerAdhocLevel);
 
 			if (!replaceInputs)
 			{
 				replaceInputs = true;
-				inputs = this->BaseStatus[adhocLevel].m64Diff.frames[frame];
+				inputs = *diffInputs;
 			}
 		}
 
-		if (this->inputsCache[adhocLevel].contains(frame))
+		if (InputsMetadata<TResource>* cached = this->inputsCache[adhocLevel].Find(frame))
 		{
-			InputsMetadata<TResource> metadata = this->inputsCache[adhocLevel][frame];
+			InputsMetadata<TResource> metadata = *cached;
 			if (stateOwnerAdhocLevel != -1)
 				metadata.stateOwnerAdhocLevel = stateOwnerAdhocLevel;
 
@@ -352,129 +403,48 @@ InputsMetadata<TResource> TopLevelScript<TResource>::GetInputsMetadata(int64_t f
 
 	//Then check actual m64.
 	//For the purposes of the frame counter, mark as adhoc level 0.
-	if (_m64->frames.count(frame))
-		return InputsMetadata<TResource>(_m64->frames[frame], frame, this, stateOwnerAdhocLevel, InputsMetadata<TResource>::InputsSource::ORIGINAL);
+	if (const Inputs* m64Inputs = _m64->frames.Find(frame))
+		return InputsMetadata<TResource>(*m64Inputs, frame, this, stateOwnerAdhocLevel, InputsMetadata<TResource>::InputsSource::ORIGINAL);
 
 	//Default to no input
 	//For the purposes of the frame counter, mark as adhoc level 0.
 	return InputsMetadata<TResource>(Inputs(0, 0, 0), frame, this, stateOwnerAdhocLevel, InputsMetadata<TResource>::InputsSource::DEFAULT);
 }
 
-template <derived_from_specialization_of<Resource> TResource>
-InputsMetadata<TResource> Script<TResource>::GetInputsMetadataAndCache(int64_t frame)
-{
-	InputsMetadata<TResource> inputs = GetInputsMetadata(frame);
-	inputsCache[_adhocLevel][frame] = inputs;
-	return inputs;
-}
-
 template <derived_from_specialization_of<Resource> TResource>
 uint64_t Script<TResource>::GetFrameCounter(InputsMetadata<TResource> cachedInputs)
 {
-	if (!cachedInputs.stateOwner->frameCounter[cachedInputs.stateOwnerAdhocLevel].contains(cachedInputs.frame))
-		cachedInputs.stateOwner->frameCounter[cachedInputs.stateOwnerAdhocLevel][cachedInputs.frame] = 0;
-
 	return cachedInputs.stateOwner->frameCounter[cachedInputs.stateOwnerAdhocLevel][cachedInputs.frame];
 }
 
 template <derived_from_specialization_of<Resource> TResource>
 uint64_t Script<TResource>::IncrementFrameCounter(InputsMetadata<TResource> cachedInputs)
 {
-	if (!cachedInputs.stateOwner->frameCounter[cachedInputs.stateOwnerAdhocLevel].contains(cachedInputs.frame))
-		cachedInputs.stateOwner->frameCounter[cachedInputs.stateOwnerAdhocLevel][cachedInputs.frame] = 0;
-
 	//Return value AFTER incrementing
 	return ++cachedInputs.stateOwner->frameCounter[cachedInputs.stateOwnerAdhocLevel][cachedInputs.frame];
 }
 
+// Saves of every script up the tree, less those desynced by a later diff
 template <derived_from_specialization_of<Resource> TResource>
 SaveMetadata<TResource> Script<TResource>::GetLatestSave(int64_t frame)
 {
 	if (resource->initialFrame > frame)
 		throw std::runtime_error("Error: attempted to load frame prior to initial frame");
 
-	//Check ad-hoc script hierarchy first, then current script
-	int64_t earlyFrame = frame;
-	SaveMetadata<TResource> bestSave;
-	for (int64_t adhocLevel = _adhocLevel; adhocLevel >= 0; adhocLevel--)
-	{
-		//Get most recent save in script
-		auto save = saveBank[adhocLevel].empty() || earlyFrame < saveBank[adhocLevel].begin()->first
-			? saveBank[adhocLevel].end()
-			: std::prev(saveBank[adhocLevel].upper_bound(earlyFrame));
-
-		//Verify save exists and select the more recent save
-		if (save != saveBank[adhocLevel].end())
-		{
-			if (!save->second.isValid())
-				saveBank[adhocLevel].erase(save->first);
-			else if (save->first >= bestSave.frame)
-				bestSave = SaveMetadata<TResource>(this, save->first, adhocLevel);
-		}
-
-		//Check for cached save
-		auto cachedSave = saveCache[adhocLevel].empty() || earlyFrame < saveCache[adhocLevel].begin()->first
-			? saveCache[adhocLevel].end()
-			: std::prev(saveCache[adhocLevel].upper_bound(earlyFrame));
-
-		if (cachedSave != saveCache[adhocLevel].end())
-		{
-			//This is the purpose of caching saves: end recursion when a cached save is found. Boosts performance.
-			if (cachedSave->second.IsValid())
-			{
-				if (cachedSave->first >= bestSave.frame)
-				{
-					//However, if there was a load between the target frame and the cached save, it may not be optimal and we should continue recursion
-					auto loadAfterCachedSave = loadTracker[adhocLevel].lower_bound(cachedSave->first);
-					if (loadAfterCachedSave != loadTracker[adhocLevel].end() && *loadAfterCachedSave < frame)
-						bestSave = cachedSave->second;
-					else
-						return cachedSave->second;
-				}
-			}
-			else
-				saveCache[adhocLevel].erase(cachedSave->first); // Delete stale cached save	
-		}
-
-		// Don't search past start of m64 diff to avoid desync
-		earlyFrame = !BaseStatus[adhocLevel].m64Diff.frames.empty()
-			? (std::min)(BaseStatus[adhocLevel].m64Diff.frames.begin()->first, (uint64_t)earlyFrame)
-			: (std::min)(frame, earlyFrame);
-
-		//If save is not before the start of the diff, we have the best possible save, so return it
-		if (bestSave.frame >= 0 && bestSave.frame >= earlyFrame)
-			return bestSave;
-	}
-
-	//Then check parent script
-	if (_parentScript)
+	for (auto save = _saveIndex->FindLatest(frame); save.owner; save = _saveIndex->FindLatest(frame))
 	{
-		auto ancestorSave = _parentScript->GetLatestSave(earlyFrame);
+		SaveMetadata<TResource> saveMetadata(save.owner, save.frame, save.adhocLevel);
+		SlotHandle<TResource>* slotHandle = saveMetadata.GetSlotHandle();
+		if (slotHandle && slotHandle->prepareLoad())
+			return saveMetadata;
 
-		//Select the more recent save
-		if (ancestorSave.frame >= bestSave.frame)
-			return ancestorSave;
+		//Drop evicted save and look again
+		save.owner->DeleteSave(save.frame, save.adhocLevel);
 	}
 
-	//Return most recent save if it exists
-	if (bestSave.frame >= 0)
-		return bestSave;
-
 	//Default to initial save
-	return SaveMetadata<TResource>(this, _initialFrame, 0, true);
-}
-
-template <derived_from_specialization_of<Resource> TResource>
-SaveMetadata<TResource> Script<TResource>::GetLatestSaveAndCache(int64_t frame)
-{
-	SaveMetadata<TResource> save = GetLatestSave(frame);
-	saveCache[_adhocLevel][save.frame] = save; // Cache save to save recursion time later
-
-	//Track load to mark cached save as optimal
-	if (!loadTracker[_adhocLevel].contains(frame))
-		loadTracker[_adhocLevel].insert(frame);
-
-	return save;
+	Script* rootScript = _saveIndex->GetOwner(0);
+	return SaveMetadata<TResource>(rootScript, rootScript->_initialFrame, 0, true);
 }
 
 template <derived_from_specialization_of<Resource> TResource>
@@ -490,9 +460,13 @@ void Script<TResource>::LongLoad(int64_t frame)
 
 	// Load most recent save at or before frame. Check child saves before
 	// parent. If target frame is in future, check if faster to frame advance or load.
-	// Also, don't cache as it is unlikely the save will be needed again.
 	auto latestSave = GetLatestSave(frame);
-	if (frame < currentFrame)
+
+	// A save from an earlier run beats replaying from anything older than it
+	int64_t replayStart = frame < currentFrame ? latestSave.frame : (std::max)(currentFrame, latestSave.frame);
+	if (resource->persistentCache && LoadPersistentSave(replayStart + 1, frame))
+		BaseStatus[_adhocLevel].nLoads++;
+	else if (frame < currentFrame)
 	{
 		resource->LoadState(latestSave.GetSlotHandle()->slotId);
 		BaseStatus[_adhocLevel].nLoads++;
@@ -502,11 +476,147 @@ void Script<TResource>::LongLoad(int64_t frame)
 
 	// If save is before target frame, play back until frame is reached
 	currentFrame = GetCurrentFrame();
-	while (currentFrame++ < frame)
-		AdvanceFrameRead();
+	int64_t nResimulatedFrames = (std::max)(frame - currentFrame, int64_t(0));
+	if (nResimulatedFrames > 0)
+	{
+		AdvanceFramesRead(nResimulatedFrames);
+		resource->nResimulatedFrames += nResimulatedFrames;
+	}
 
 	// Create a save as it is likely that very many frames were advanced since the most recent one.
 	Save();
+
+	if (resource->persistentCache && nResimulatedFrames > 0)
+		StorePersistentSave(nResimulatedFrames);
+}
+
+template <derived_from_specialization_of<Resource> TResource>
+uint64_t Script<TResource>::HashInputs(uint64_t hash, Inputs inputs)
+{
+	uint8_t packed[4] = {uint8_t(inputs.buttons), uint8_t(inputs.buttons >> 8), uint8_t(inputs.stick_x), uint8_t(inputs.stick_y)};
+	return PersistentSaveCache::HashBytes(packed, sizeof(packed), hash);
+}
+
+// Latest frame at or before frame with a known input prefix hash. Hashes of
+// lower levels and the parent only hold up to the first frame changed above them.
+template <derived_from_specialization_of<Resource> TResource>
+int64_t Script<TResource>::FindInputPrefixHash(int64_t frame, uint64_t& hash)
+{
+	int64_t latest = FrameSet::NONE;
+	for (int64_t adhocLevel = _adhocLevel; adhocLevel >= 0; adhocLevel--)
+	{
+		FrameMap<uint64_t>& hashes = inputPrefixHashes[adhocLevel];
+		int64_t found = hashes.FindLatest(frame); // NONE sorts before every frame
+		if (found > latest)
+		{
+			latest = found;
+			hash = *hashes.Find(found);
+		}
+
+		const InputTimeline& diff = BaseStatus[adhocLevel].m64Diff.frames;
+		if (!diff.Empty())
+			frame = (std::min)(frame, diff.First());
+	}
+
+	uint64_t parentHash;
+	if (_parentScript)
+	{
+		int64_t found = _parentScript->FindInputPrefixHash(frame, parentHash);
+		if (found > latest)
+		{
+			latest = found;
+			hash = parentHash;
+		}
+	}
+
+	return latest;
+}
+
+// Hashes only the inputs after the latest known prefix hash
+template <derived_from_specialization_of<Resource> TResource>
+uint64_t Script<TResource>::GetInputPrefixHash(int64_t frame)
+{
+	uint64_t hash = 0xcbf29ce484222325ull;
+	int64_t inputFrame = FindInputPrefixHash(frame, hash);
+	if (inputFrame == frame)
+		return hash;
+
+	for (inputFrame = (std::max)(inputFrame, int64_t(0)); inputFrame < frame; inputFrame++)
+	{
+		hash = HashInputs(hash, GetInputsMetadata(inputFrame).inputs);
+	}
+
+	inputPrefixHashes[_adhocLevel][frame] = hash;
+	return hash;
+}
+
+// Loads the deepest save from an earlier run in [minFrame, frame] whose input prefix matches ours
+template <derived_from_specialization_of<Resource> TResource>
+bool Script<TResource>::LoadPersistentSave(int64_t minFrame, int64_t frame)
+{
+	if (resource->initialFrame != 0)
+		return false;
+
+	std::vector<int64_t> frames = resource->persistentCache->GetFrames(minFrame, frame);
+	if (frames.empty())
+		return false;
+
+	// Shallowest first, so each hash resumes from the one before it
+	std::map<int64_t, uint64_t> prefixHashes;
+	for (auto candidate = frames.rbegin(); candidate != frames.rend(); candidate++)
+		prefixHashes[*candidate] = GetInputPrefixHash(*candidate);
+
+	std::vector<uint8_t> buffer;
+	std::remove_cvref_t<decltype(resource->startSave)> state;
+	for (int64_t cachedFrame : frames)
+	{
+		if (!resource->persistentCache->Read(cachedFrame, prefixHashes[cachedFrame], buffer))
+			continue;
+
+		// The resource may refuse a state it can't restore, e.g. one saved
+		// with the game mapped elsewhere. It is then rebuilt on the way.
+		if (!resource->deserialize(buffer, state))
+		{
+			resource->persistentCache->Erase(cachedFrame, prefixHashes[cachedFrame]);
+			continue;
+		}
+
+		resource->load(state);
+		if (static_cast<int64_t>(GetCurrentFrame()) != cachedFrame)
+			throw std::runtime_error("Persistent save for frame " + std::to_string(cachedFrame) + " loaded the wrong frame.");
+
+		// Keep it in memory too, so later loads don't go back to disk
+		Save();
+		return true;
+	}
+
+	return false;
+}
+
+// Stores the LongLoad target if replaying to it costs more than writing it out
+template <derived_from_specialization_of<Resource> TResource>
+void Script<TResource>::StorePersistentSave(int64_t nResimulatedFrames)
+{
+	PersistentSaveCache& cache = *resource->persistentCache;
+	if (resource->initialFrame != 0)
+		return;
+	if (cache.nWrites > 0 && double(nResimulatedFrames) * resource->getFrameAdvanceTime() <= double(cache.writeTicks) / cache.nWrites)
+		return;
+
+	int64_t frame = GetCurrentFrame();
+	uint64_t hash = GetInputPrefixHash(frame);
+	if (cache.Contains(frame, hash))
+		return;
+
+	auto start = get_time();
+	std::remove_cvref_t<decltype(resource->startSave)> state;
+	std::vector<uint8_t> buffer;
+	resource->save(state);
+	if (resource->serialize(state, buffer))
+	{
+		cache.Write(frame, hash, buffer);
+		cache.writeTicks += get_time() - start;
+	}
 }
 
 template <derived_from_specialization_of<Resource> TResource>
@@ -516,7 +626,7 @@ void Script<TResource>::LoadBase(uint64_t frame, bool desync)
 
 	// Load most recent save at or before frame. Check child saves before
 	// parent. If target frame is in future, check if faster to frame advance or load.
-	auto latestSave = GetLatestSaveAndCache(frame);
+	auto latestSave = GetLatestSave(frame);
 	if (desync || frame < currentFrame)
 	{
 		resource->LoadState(latestSave.GetSlotHandle()->slotId);
@@ -525,47 +635,51 @@ void Script<TResource>::LoadBase(uint64_t frame, bool desync)
 	else if (latestSave.frame > static_cast<int64_t>(frame) && resource->shouldLoad(latestSave.frame - currentFrame))
 		resource->LoadState(latestSave.GetSlotHandle()->slotId);
 
-	// If save is before target frame, play back until frame is reached
+	// If save is before target frame, play back until frame is reached.
+	// Frames are advanced in batches that end wherever a save is due.
 	currentFrame = GetCurrentFrame();
+	if (currentFrame >= frame)
+		return;
+
 	uint64_t frameCounter = 0;
+	auto cachedInputs = GetInputsMetadata(currentFrame);
+	_inputsBuffer.clear();
 	while (currentFrame++ < frame)
 	{
-		AdvanceFrameRead();
+		_inputsBuffer.push_back(cachedInputs.inputs);
 
-		auto cachedInputs = GetInputsMetadataAndCache(currentFrame);
+		cachedInputs = GetInputsMetadata(currentFrame);
 		frameCounter += IncrementFrameCounter(cachedInputs);
 
 		//Estimate future frame advances from aggregate of historical frame advances on this input segment
 		//If it reaches a certain threshold, creating a save is performant
 		if (resource->shouldSave(frameCounter))
 		{
-			SaveMetadata<TResource> cachedSave = cachedInputs.stateOwner->Save(cachedInputs.stateOwnerAdhocLevel);
-			saveCache[_adhocLevel][currentFrame] = cachedSave;
+			AdvanceFrames(_inputsBuffer);
+			resource->nResimulatedFrames += _inputsBuffer.size();
+			_inputsBuffer.clear();
+
+			cachedInputs.stateOwner->Save(cachedInputs.stateOwnerAdhocLevel);
 			frameCounter = 0;
 		}
 	}
+
+	AdvanceFrames(_inputsBuffer);
+	resource->nResimulatedFrames += _inputsBuffer.size();
 }
 
 // Load method specifically for Script.Execute() and Script.Modify(), checks for desyncs
 template <derived_from_specialization_of<Resource> TResource>
-void Script<TResource>::Revert(uint64_t frame, const M64Diff& m64, std::map<int64_t, SlotHandle<TResource>>& childSaveBank)
+void Script<TResource>::Revert(uint64_t frame, const M64Diff& m64, FrameMap<SlotHandle<TResource>>& childSaveBank)
 {
 	// Check if script altered state
-	bool desync = (!m64.frames.empty()) && (m64.frames.begin()->first < GetCurrentFrame());
+	bool desync = (!m64.frames.Empty()) && (uint64_t(m64.frames.First()) < GetCurrentFrame());
 
-	auto lastSyncedSave = childSaveBank.end();
-	if (!m64.frames.empty() && !childSaveBank.empty())
-	{
-		auto firstDesyncedSave = childSaveBank.upper_bound(m64.frames.begin()->first);
-		if (firstDesyncedSave != childSaveBank.begin())
-			lastSyncedSave = std::prev(firstDesyncedSave);
-	}
+	//Saves up to the first diff frame precede every changed input
+	int64_t lastSyncedFrame = m64.frames.Empty() ? INT64_MAX : m64.frames.First();
 
 	//Move child saves to parent that are not desynced
-	//If child is ad-hoc script, pop the save bank
-	std::move(childSaveBank.begin(), lastSyncedSave, std::insert_iterator(saveBank[_adhocLevel], saveBank[_adhocLevel].end()));
-	if (saveBank.contains(_adhocLevel + 1))
-		saveBank.erase(_adhocLevel + 1);
+	PopSaveBank(childSaveBank, lastSyncedFrame);
 
 	LoadBase(frame, desync);
 }
@@ -575,18 +689,11 @@ void Script<TResource>::Rollback(uint64_t frame)
 {
 	// Roll back diff and savebank to target frame. Note that rollback on diff
 	// includes target frame.
-	if (!BaseStatus[_adhocLevel].m64Diff.frames.empty())
+	int64_t firstFrame = BaseStatus[_adhocLevel].m64Diff.frames.FindNext(frame);
+	if (firstFrame != FrameSet::NONE)
 	{
-		int64_t firstFrame = BaseStatus[_adhocLevel].m64Diff.frames.lower_bound(frame)->first;
-
-		BaseStatus[_adhocLevel].m64Diff.frames.erase(
-			BaseStatus[_adhocLevel].m64Diff.frames.lower_bound(frame),
-			BaseStatus[_adhocLevel].m64Diff.frames.end());
-
-		inputsCache[_adhocLevel].erase(inputsCache[_adhocLevel].lower_bound(firstFrame), inputsCache[_adhocLevel].end());
-		frameCounter[_adhocLevel].erase(frameCounter[_adhocLevel].upper_bound(firstFrame), frameCounter[_adhocLevel].end());
-		saveBank[_adhocLevel].erase(saveBank[_adhocLevel].upper_bound(firstFrame), saveBank[_adhocLevel].end());
-		saveCache[_adhocLevel].erase(saveCache[_adhocLevel].upper_bound(firstFrame), saveCache[_adhocLevel].end());
+		BaseStatus[_adhocLevel].m64Diff.frames.EraseFrom(frame);
+		EraseFrameData(firstFrame);
 	}
 
 	//Desyncs should be impossible for rollback because no inputs are changed prior to frame being loaded
@@ -598,25 +705,21 @@ template <derived_from_specialization_of<Resource> TResource>
 void Script<TResource>::RollForward(int64_t frame)
 {
 	// Check if script altered state
-	bool desync = (!BaseStatus[_adhocLevel].m64Diff.frames.empty()) && (BaseStatus[_adhocLevel].m64Diff.frames.begin()->first < GetCurrentFrame());
+	InputTimeline& diff = BaseStatus[_adhocLevel].m64Diff.frames;
+	bool desync = (!diff.Empty()) && (uint64_t(diff.First()) < GetCurrentFrame());
 
-	if (!BaseStatus[_adhocLevel].m64Diff.frames.empty())
+	if (!diff.Empty())
 	{
-		int64_t firstFrame = BaseStatus[_adhocLevel].m64Diff.frames.begin()->first;
+		int64_t firstFrame = diff.First();
 
 		//Roll forward inputs through frame prior to target frame
-		auto inputsUpperBound = BaseStatus[_adhocLevel].m64Diff.frames.upper_bound(frame - 1);
-		if (inputsUpperBound == BaseStatus[_adhocLevel].m64Diff.frames.begin())
-			inputsUpperBound = BaseStatus[_adhocLevel].m64Diff.frames.end();
+		int64_t lastFrameBefore = diff.FindLatest(frame - 1);
+		if (lastFrameBefore == FrameSet::NONE)
+			diff.Clear();
 		else
-			inputsUpperBound = std::prev(inputsUpperBound);
-
-		BaseStatus[_adhocLevel].m64Diff.frames.erase(BaseStatus[_adhocLevel].m64Diff.frames.begin(), inputsUpperBound);
+			diff.EraseBefore(lastFrameBefore);
 
-		inputsCache[_adhocLevel].erase(inputsCache[_adhocLevel].lower_bound(firstFrame), inputsCache[_adhocLevel].end());
-		frameCounter[_adhocLevel].erase(frameCounter[_adhocLevel].upper_bound(firstFrame), frameCounter[_adhocLevel].end());
-		saveBank[_adhocLevel].erase(saveBank[_adhocLevel].upper_bound(firstFrame), saveBank[_adhocLevel].end());
-		saveCache[_adhocLevel].erase(saveCache[_adhocLevel].upper_bound(firstFrame), saveCache[_adhocLevel].end());
+		EraseFrameData(firstFrame);
 	}
 
 	LoadBase(frame, desync);
@@ -627,21 +730,15 @@ template <derived_from_specialization_of<Resource> TResource>
 void Script<TResource>::Restore(int64_t frame)
 {
 	// Check if script altered state
-	bool desync = (!BaseStatus[_adhocLevel].m64Diff.frames.empty()) && (BaseStatus[_adhocLevel].m64Diff.frames.begin()->first < GetCurrentFrame());
+	InputTimeline& diff = BaseStatus[_adhocLevel].m64Diff.frames;
+	bool desync = (!diff.Empty()) && (uint64_t(diff.First()) < GetCurrentFrame());
 
 	// Clear diff, frame counter and savebank
-	if (!BaseStatus[_adhocLevel].m64Diff.frames.empty())
+	if (!diff.Empty())
 	{
-		int64_t firstFrame = BaseStatus[_adhocLevel].m64Diff.frames.begin()->first;
-
-		BaseStatus[_adhocLevel].m64Diff.frames.erase(
-			BaseStatus[_adhocLevel].m64Diff.frames.lower_bound(frame),
-			BaseStatus[_adhocLevel].m64Diff.frames.end());
-
-		inputsCache[_adhocLevel].erase(inputsCache[_adhocLevel].lower_bound(firstFrame), inputsCache[_adhocLevel].end());
-		frameCounter[_adhocLevel].erase(frameCounter[_adhocLevel].upper_bound(firstFrame), frameCounter[_adhocLevel].end());
-		saveBank[_adhocLevel].erase(saveBank[_adhocLevel].upper_bound(firstFrame), saveBank[_adhocLevel].end());
-		saveCache[_adhocLevel].erase(saveCache[_adhocLevel].upper_bound(firstFrame), saveCache[_adhocLevel].end());
+		int64_t firstFrame = diff.First();
+		diff.EraseFrom(frame);
+		EraseFrameData(firstFrame);
 	}
 
 	LoadBase(frame, desync);
@@ -652,7 +749,7 @@ void Script<TResource>::Save()
 {
 	int64_t currentFrame = GetCurrentFrame();
 	auto inputsMetadata = GetInputsMetadata(currentFrame);
-	saveCache[_adhocLevel][currentFrame] = inputsMetadata.stateOwner->Save(inputsMetadata.stateOwnerAdhocLevel);
+	inputsMetadata.stateOwner->Save(inputsMetadata.stateOwnerAdhocLevel);
 }
 
 //Internal version of Save() that specifies adhoc level, that can be called by a child script
@@ -661,12 +758,10 @@ SaveMetadata<TResource> Script<TResource>::Save(int64_t adhocLevel)
 {
 	//Desyncs should always clear future saves, so if a save already exists there is no need to overwrite it
 	int64_t currentFrame = GetCurrentFrame();
-	if (!saveBank[adhocLevel].contains(currentFrame))
+	if (!saveBank[adhocLevel].Contains(currentFrame))
 	{
-		saveBank[adhocLevel].emplace(
-			std::piecewise_construct,
-			std::forward_as_tuple(currentFrame),
-			std::forward_as_tuple(resource, resource->SaveState()));
+		saveBank[adhocLevel].TryEmplace(currentFrame, resource, resource->SaveState());
+		_saveIndex->Insert(_saveDepth + adhocLevel, currentFrame);
 		BaseStatus[adhocLevel].nSaves++;
 	}
 
@@ -681,18 +776,17 @@ void Script<TResource>::OptionalSave()
 {
 	//Integrate frame counter, saving only if threshold is reached
 	int64_t currentFrame = GetCurrentFrame();
-	int64_t latestSaveFrame = GetLatestSaveAndCache(currentFrame).frame;
+	int64_t latestSaveFrame = GetLatestSave(currentFrame).frame;
 	uint64_t frameCounter = 0;
 	for (int64_t frame = latestSaveFrame + 1; frame <= currentFrame; frame++)
 	{
-		auto cachedInputs = GetInputsMetadataAndCache(frame);
+		auto cachedInputs = GetInputsMetadata(frame);
 		frameCounter += GetFrameCounter(cachedInputs);
 
 		if (resource->shouldSave(frameCounter / 2))
 		{
 			//Create save at the current frame in current frame state owner
-			SaveMetadata<TResource> cachedSave = cachedInputs.stateOwner->Save(cachedInputs.stateOwnerAdhocLevel);
-			saveCache[_adhocLevel][currentFrame] = cachedSave;
+			cachedInputs.stateOwner->Save(cachedInputs.stateOwnerAdhocLevel);
 			break;
 		}
 	}
@@ -701,27 +795,62 @@ void Script<TResource>::OptionalSave()
 template <derived_from_specialization_of<Resource> TResource>
 void Script<TResource>::DeleteSave(int64_t frame, int64_t adhocLevel)
 {
-	saveBank[adhocLevel].erase(frame);
+	if (!saveBank[adhocLevel].Contains(frame))
+		return;
+
+	_saveIndex->Erase(_saveDepth + adhocLevel, frame);
+	saveBank[adhocLevel].Erase(frame);
 }
 
+// Called after the diff changed from frame on. Inputs from frame on are
+// stale, as are saves and frame counters after it.
 template <derived_from_specialization_of<Resource> TResource>
-void Script<TResource>::SetInputs(Inputs inputs)
+void Script<TResource>::EraseFrameData(int64_t frame)
+{
+	inputsCache[_adhocLevel].EraseFrom(frame);
+	inputPrefixHashes[_adhocLevel].EraseAfter(frame);
+	frameCounter[_adhocLevel].EraseAfter(frame);
+
+	FrameMap<SlotHandle<TResource>>& saves = saveBank[_adhocLevel];
+	for (int64_t saveFrame = saves.FindNext(frame + 1); saveFrame != FrameSet::NONE; saveFrame = saves.FindNext(saveFrame + 1))
+		_saveIndex->Erase(_saveDepth + _adhocLevel, saveFrame);
+	saves.EraseAfter(frame);
+
+	//Saves of lower levels and parent scripts after the diff start are desynced
+	const InputTimeline& diff = BaseStatus[_adhocLevel].m64Diff.frames;
+	_saveIndex->SetBound(diff.Empty() ? INT64_MAX : diff.First());
+}
+
+// Moves the saves of a finished child script or ad-hoc level up to this
+// level, keeping those up to lastSyncedFrame that this level doesn't have
+template <derived_from_specialization_of<Resource> TResource>
+void Script<TResource>::PopSaveBank(FrameMap<SlotHandle<TResource>>& childSaveBank, int64_t lastSyncedFrame)
 {
-	uint16_t* buttonDllAddr = (uint16_t*)resource->addr("gControllerPads");
-	buttonDllAddr[0] = inputs.buttons;
+	int64_t depth = _saveDepth + _adhocLevel;
+	for (int64_t frame = childSaveBank.FindNext(FrameSet::NONE); frame != FrameSet::NONE; frame = childSaveBank.FindNext(frame + 1))
+	{
+		_saveIndex->Erase(depth + 1, frame);
+		if (frame <= lastSyncedFrame && !saveBank[_adhocLevel].Contains(frame))
+			_saveIndex->Insert(depth, frame);
+	}
+	_saveIndex->Pop();
 
-	int8_t* xStickDllAddr = (int8_t*)resource->addr("gControllerPads") + 2;
-	xStickDllAddr[0] = inputs.stick_x;
+	childSaveBank.MoveInto(saveBank[_adhocLevel], lastSyncedFrame);
+	if (saveBank.size() > size_t(_adhocLevel + 1))
+		saveBank[_adhocLevel + 1].Clear();
+}
 
-	int8_t* yStickDllAddr = (int8_t*)resource->addr("gControllerPads") + 3;
-	yStickDllAddr[0] = inputs.stick_y;
+template <derived_from_specialization_of<Resource> TResource>
+void Script<TResource>::SetInputs(Inputs inputs)
+{
+	resource->SetInputs(inputs);
 }
 
 // Only checks base diff, i.e. ad-hoc level 0
 template <derived_from_specialization_of<Resource> TResource>
 bool Script<TResource>::IsDiffEmpty()
 {
-	return BaseStatus[0].m64Diff.frames.empty();
+	return BaseStatus[0].m64Diff.frames.Empty();
 }
 
 template <derived_from_specialization_of<Resource> TResource>
@@ -811,14 +940,21 @@ BaseScriptStatus Script<TResource>::ExecuteAdhocBase(F adhocScript)
 	//Save state if performant
 	OptionalSave();
 
-	//Increment adhoc level
+	//Increment adhoc level, reusing the containers of an earlier script at
+	//this level if there was one. They were emptied when it returned.
 	_adhocLevel++;
-	BaseStatus[_adhocLevel];
-	saveBank[_adhocLevel];
-	frameCounter[_adhocLevel];
-	saveCache[_adhocLevel];
-	inputsCache[_adhocLevel];
-	loadTracker[_adhocLevel];
+	if (BaseStatus.size() <= size_t(_adhocLevel))
+	{
+		BaseStatus.emplace_back();
+		saveBank.emplace_back();
+		frameCounter.emplace_back();
+		inputsCache.emplace_back();
+		inputPrefixHashes.emplace_back();
+	}
+	else
+		BaseStatus[_adhocLevel] = BaseScriptStatus();
+
+	_saveIndex->Push(this, _adhocLevel);
 
 	BaseStatus[_adhocLevel].validated = true;
 
@@ -843,12 +979,10 @@ BaseScriptStatus Script<TResource>::ExecuteAdhocBase(F adhocScript)
 	//Decrement adhoc level, revert state and return status
 	//NOTE: saveBank is not popped here as the saves may be moved to the parent.
 	//Caller is responsible for popping it.
-	BaseScriptStatus status = BaseStatus[_adhocLevel];
-	BaseStatus.erase(_adhocLevel);
-	frameCounter.erase(_adhocLevel);
-	saveCache.erase(_adhocLevel);
-	inputsCache.erase(_adhocLevel);
-	loadTracker.erase(_adhocLevel);
+	BaseScriptStatus status = std::move(BaseStatus[_adhocLevel]);
+	frameCounter[_adhocLevel].Clear();
+	inputsCache[_adhocLevel].Clear();
+	inputPrefixHashes[_adhocLevel].Clear();
 	_adhocLevel--;
 
 	BaseStatus[_adhocLevel].nLoads += status.nLoads;
@@ -870,10 +1004,7 @@ SlotHandle<TResource>* SaveMetadata<TResource>::GetSlotHandle()
 	if (script->saveBank.size() <= static_cast<uint64_t>(adhocLevel))
 		return nullptr;
 
-	if (!script->saveBank[adhocLevel].contains(frame))
-		return nullptr;
-
-	return &script->saveBank[adhocLevel].find(frame)->second;
+	return script->saveBank[adhocLevel].Find(frame);
 }
 
 template <derived_from_specialization_of<Resource> TResource>
@@ -885,7 +1016,7 @@ bool SaveMetadata<TResource>::IsValid()
 
 	if (!slotHandle->isValid())
 	{
-		script->saveBank[adhocLevel].erase(frame);
+		script->DeleteSave(frame, adhocLevel);
 		return false;
 	}
 
@@ -315,7 +315,7 @@ public:
 
 			status1 = ExecuteFromTuple<TScript>(*(paramsList.begin()));
 			if (status1.asserted)
-				incumbentDiff.frames.insert(status1.m64Diff.frames.begin(), status1.m64Diff.frames.end());
+				incumbentDiff.frames.Merge(status1.m64Diff.frames, false);
 
 			if (status1.asserted && script->ExecuteAdhoc([&]() { return terminator(&status1); }).executed)
 				return true;
@@ -382,7 +382,7 @@ public:
 
 				status1 = ExecuteFromTuple<TScript>(params);
 				if (status1.asserted)
-					incumbentDiff.frames.insert(status1.m64Diff.frames.begin(), status1.m64Diff.frames.end());
+					incumbentDiff.frames.Merge(status1.m64Diff.frames, false);
 
 				if (status1.asserted && script->ExecuteAdhoc([&]() { return terminator(&status1); }).executed)
 					return true;
@@ -445,7 +445,7 @@ public:
 					{
 						status1 = ModifyFromTuple<TScript>(*(paramsList.begin()));
 						if (status1.asserted)
-							incumbentDiff.frames.insert(status1.m64Diff.frames.begin(), status1.m64Diff.frames.end());
+							incumbentDiff.frames.Merge(status1.m64Diff.frames, false);
 
 						if (!status1.asserted)
 							return false;
@@ -545,7 +545,7 @@ public:
 					{
 						status1 = ModifyFromTuple<TScript>(params);
 						if (status1.asserted)
-							incumbentDiff.frames.insert(status1.m64Diff.frames.begin(), status1.m64Diff.frames.end());
+							incumbentDiff.frames.Merge(status1.m64Diff.frames, false);
 
 						if (!status1.asserted)
 							return false;
@@ -845,7 +845,7 @@ public:
 
 				status1 = ExecuteFromTupleAdhoc<TCompareStatus>(std::forward<F>(adhocScript), *(paramsList.begin()));
 				if (status1.executed)
-					incumbentDiff.frames.insert(status1.m64Diff.frames.begin(), status1.m64Diff.frames.end());
+					incumbentDiff.frames.Merge(status1.m64Diff.frames, false);
 
 				if (status1.executed && script->ExecuteAdhoc([&]() { return terminator(&status1); }).executed)
 					return true;
@@ -912,7 +912,7 @@ public:
 
 				status1 = ExecuteFromTupleAdhoc<TCompareStatus>(std::forward<G>(adhocScript), params);
 				if (status1.executed)
-					incumbentDiff.frames.insert(status1.m64Diff.frames.begin(), status1.m64Diff.frames.end());
+					incumbentDiff.frames.Merge(status1.m64Diff.frames, false);
 
 				if (status1.executed && script->ExecuteAdhoc([&]() { return terminator(&status1); }).executed)
 					return true;
@@ -976,7 +976,7 @@ public:
 					{
 						status1 = ModifyFromTupleAdhoc<TCompareStatus>(std::forward<F>(adhocScript), *(paramsList.begin()));
 						if (status1.executed)
-							incumbentDiff.frames.insert(status1.m64Diff.frames.begin(), status1.m64Diff.frames.end());
+							incumbentDiff.frames.Merge(status1.m64Diff.frames, false);
 
 						if (!status1.executed)
 							return false;
@@ -1076,7 +1076,7 @@ public:
 					{
 						status1 = ModifyFromTupleAdhoc<TCompareStatus>(std::forward<G>(adhocScript), params);
 						if (status1.executed)
-							incumbentDiff.frames.insert(status1.m64Diff.frames.begin(), status1.m64Diff.frames.end());
+							incumbentDiff.frames.Merge(status1.m64Diff.frames, false);
 
 						if (!status1.executed)
 							return false;
@@ -1149,8 +1149,8 @@ private:
 	M64Diff MergeDiffs(const M64Diff& diff1, const M64Diff& diff2)
 	{
 		M64Diff newDiff;
-		newDiff.frames.insert(diff1.frames.begin(), diff1.frames.end());
-		newDiff.frames.insert(diff2.frames.begin(), diff2.frames.end());
+		newDiff.frames.Merge(diff1.frames);
+		newDiff.frames.Merge(diff2.frames, false);
 
 		return newDiff;
 	}
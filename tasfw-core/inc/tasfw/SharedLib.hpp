@@ -64,12 +64,16 @@ class SharedLib
 {
 	std::string libFileName;
 #if defined(_WIN32)
+	std::filesystem::path isolatedCopy; // temporary copy deleted on unload
 	HMODULE handle;
 #elif defined(__linux__)
+	int memfd = -1; // in-memory copy backing an isolated instance
 	void* handle;
 #endif
 public:
-	SharedLib(const std::filesystem::path& path);
+	// An isolated library gets its own copy of every global, even if the same
+	// path is already loaded. Otherwise the loader shares one copy per path.
+	SharedLib(const std::filesystem::path& path, bool isolated = false);
 	~SharedLib();
 
 	void* get(const char* symbol) const;
@@ -1,4 +1,7 @@
 #pragma once
+#include <array>
+#include <memory>
+#include <random>
 #include <unordered_map>
 #include <vector>
 #include "tasfw/Resource.hpp"
@@ -7,15 +10,135 @@
 #ifndef LIBSM64_H
 #define LIBSM64_H
 
+enum class LibSm64Tracking : uint8_t
+{
+	WRITE_FAULT, // write-protect the sections and record pages from a SIGSEGV handler
+	SOFT_DIRTY // read soft-dirty bits from /proc/self/pagemap; needs CONFIG_MEM_SOFT_DIRTY
+};
+
+enum class LibSm64Savestates : uint8_t
+{
+	PAGE_COPY, // copy written pages into the slot, and back on load
+	MEMFD_REMAP, // keep slots in memfds and map their pages copy-on-write on load. Cheap loads, but
+	             // the first write to each page after one faults and copies it, which advances pay for
+	PAGE_DEDUP // like PAGE_COPY, but identical pages are stored once and shared between slots
+};
+
 class LibSm64Config
 {
 public:
 	std::filesystem::path dllPath;
 	CountryCode countryCode;
 	bool lightweight; // true = faster, but accuracy not guaranteed in all situations
+	// Linux lightweight mode, with page-copy savestates and no incremental saves:
+	// the pages written during a warm-up become a region profile, which later
+	// saves copy without tracking writes
+	std::filesystem::path regionProfileDirectory; // if set, profiles are kept here across runs, keyed by the DLL's hash
+	int64_t profileWarmupFrames = 3600;
+	int64_t profileCheckInterval = 0; // saves between scans for pages that drifted out of the profile, 0 = never
+	std::filesystem::path saveSpillDirectory; // if set, cold savestates spill to a scratch file here
+	int64_t saveSpillCapacity = 8ll * 1024 * 1024 * 1024; //8 GB
+	// If set, LongLoad targets are cached here across runs. Cached states only
+	// load back with the game at the same address, so run with ASLR disabled
+	// (e.g. setarch -R) for them to be reused.
+	std::filesystem::path saveCacheDirectory;
+	bool incrementalSaves = false; // Linux only: saves copy only pages written since the previous save or load
+	LibSm64Tracking tracking = LibSm64Tracking::WRITE_FAULT; // Linux only
+	bool nonTemporalSaves = false; // Linux only: save without pulling slot pages into the cache
+	LibSm64Savestates savestates = LibSm64Savestates::PAGE_COPY; // Linux only, MEMFD_REMAP and PAGE_DEDUP not with incrementalSaves
 };
 
 constexpr int pagesize = 4096;
+using LibSm64Page = std::array<uint8_t, pagesize>;
+// Sorted by address
+using LibSm64PageTable = std::vector<std::pair<uint8_t*, std::shared_ptr<const LibSm64Page>>>;
+
+class alignas(pagesize) LibSm64AlignedPage
+{
+public:
+	uint8_t bytes[pagesize];
+};
+
+#if !defined(_WIN32)
+class LibSm64PageHash
+{
+public:
+	uint64_t low = 0;
+	uint64_t high = 0;
+
+	bool operator==(const LibSm64PageHash&) const = default;
+};
+
+// Content-addressed pages shared by the slots of one resource. A page is
+// freed when the last slot referencing it lets go, so the store's size is the
+// resource's unique savestate bytes.
+class LibSm64PageStore : public std::enable_shared_from_this<LibSm64PageStore>
+{
+public:
+	class Stats
+	{
+	public:
+		uint64_t nPages = 0; // distinct pages held
+		uint64_t nStores = 0;
+		uint64_t nDuplicates = 0; // stores that found an identical page
+	};
+
+	std::shared_ptr<const LibSm64AlignedPage> Store(const uint8_t* page);
+	size_t GetSize() const { return _stats.nPages * pagesize; }
+	const Stats& GetStats() const { return _stats; }
+
+private:
+	class HashHasher
+	{
+	public:
+		size_t operator()(const LibSm64PageHash& hash) const { return size_t(hash.low); }
+	};
+
+	std::unordered_map<LibSm64PageHash, std::weak_ptr<const LibSm64AlignedPage>, HashHasher> _pages;
+	Stats _stats;
+};
+
+// memfd laid out like the tracked pages, holding a page at pageIndex * pagesize
+class LibSm64SnapshotFile
+{
+public:
+	int fd = -1;
+
+	LibSm64SnapshotFile(size_t size);
+	~LibSm64SnapshotFile();
+	LibSm64SnapshotFile(const LibSm64SnapshotFile&) = delete;
+	LibSm64SnapshotFile& operator=(const LibSm64SnapshotFile&) = delete;
+};
+
+// Snapshot files packed side by side into a few memfds, so that hundreds of
+// slots don't each hold a descriptor. A released snapshot's pages are punched
+// out and its place is handed to the next one.
+class LibSm64SnapshotPool : public std::enable_shared_from_this<LibSm64SnapshotPool>
+{
+public:
+	class Snapshot
+	{
+	public:
+		int fd = -1;
+		size_t offset = 0; // of the first tracked page
+	};
+
+	LibSm64SnapshotPool(size_t snapshotSize) : _snapshotSize(snapshotSize) { }
+	// nPages is what the caller writes into the snapshot, charged until it is released
+	std::shared_ptr<const Snapshot> Acquire(size_t nPages);
+	size_t GetFileCount() const { return _files.size(); }
+	size_t GetSize() const { return _nPages * pagesize; }
+
+private:
+	static constexpr size_t snapshotsPerFile = 64;
+
+	size_t _snapshotSize;
+	size_t _nPages = 0; // written into live snapshots
+	std::vector<std::unique_ptr<LibSm64SnapshotFile>> _files;
+	std::vector<size_t> _freeSnapshots;
+};
+#endif
+
 class LibSm64Mem
 {
 public:
@@ -23,30 +146,128 @@ public:
 	std::vector<uint8_t> buf1;
 	std::vector<uint8_t> buf2;
 #else
-	std::unordered_map<void*, std::array<uint8_t, pagesize>> changed_regions;
+	// One bit per tracked page, and the set pages in ascending address order.
+	// Both keep their capacity when the slot record is reused.
+	std::vector<uint64_t> pageBitmap;
+	std::vector<LibSm64AlignedPage> payload;
 	uint64_t region_count_at_save_time=0;
+
+	// MEMFD_REMAP: the set pages of pageBitmap, instead of payload
+	std::shared_ptr<const LibSm64SnapshotPool::Snapshot> snapshot;
+
+	// PAGE_DEDUP: the set pages of pageBitmap, instead of payload
+	std::vector<std::shared_ptr<const LibSm64AlignedPage>> pageRefs;
+
+	// Incremental saves: every page written since init. Pages that were clean
+	// at save time are shared with the previous snapshot, and stay alive for
+	// as long as any snapshot refers to them.
+	std::shared_ptr<const LibSm64PageTable> pages;
 #endif
 };
 
-class LibSm64 : public Resource<LibSm64Mem>
+class LibSm64 final : public Resource<LibSm64Mem>
 {
 public:
 	SharedLib dll;
 	std::vector<SegVal> segment;
 	const LibSm64Config config;
+	uint8_t* imageBegin = nullptr; // span of all mapped sections, part of the persistent key
+	uint8_t* imageEnd = nullptr;
 
 #if !defined(_WIN32)
-	std::vector<uint8_t> original_buf1;
-	std::vector<uint8_t> original_buf2;
+	// Page-aligned spans of .data and .bss under the write trap, with their contents after init
+	class TrackedRange
+	{
+	public:
+		uint8_t* begin;
+		uint8_t* end;
+		std::vector<uint8_t> original;
+		size_t firstPage; // index of begin in the page bitmaps
+	};
+	std::vector<TrackedRange> trackedRanges;
+
+	// Pages of this instance written since tracking started, or since the last
+	// save or load in incremental mode. The fault handler appends to this.
+	mutable std::vector<uint8_t*> regions_of_interest;
 #endif
 
 	LibSm64(const LibSm64Config& config);
+	~LibSm64();
 	void save(LibSm64Mem& state) const;
 	void load(const LibSm64Mem& state);
 	void advance();
+	void advanceFrames(std::span<const Inputs> inputs);
 	void* addr(const char* symbol) const;
 	std::size_t getStateSize(const LibSm64Mem& state) const;
-	uint32_t getCurrentFrame() const;
+	uint32_t getCurrentFrame() const { return *getSymbol<uint32_t>(GameSymbol::gGlobalTimer) - 1; }
+	bool serialize(const LibSm64Mem& state, std::vector<uint8_t>& out) const;
+	bool deserialize(std::span<const uint8_t> in, LibSm64Mem& state) const;
+	uint64_t getPersistentKey() const;
+	std::size_t getSharedStateSize() const;
+	void releaseState(LibSm64Mem& state) const;
+	uint64_t getStateEpoch() const;
+
+private:
+	void(TAS_FW_STDCALL* _sm64Update)() = nullptr;
+	// States from another instance can't rely on regions_of_interest matching ours
+	const uint64_t _sessionId = std::random_device {}() | (uint64_t(std::random_device {}()) << 32);
+
+#if !defined(_WIN32)
+	// Snapshot the tracked pages currently match, apart from pages written since
+	mutable std::shared_ptr<const LibSm64PageTable> _currentPages = std::make_shared<LibSm64PageTable>();
+	// Incremental pages alive in any snapshot, charged once by getSharedStateSize()
+	std::shared_ptr<int64_t> _nIncrementalPages = std::make_shared<int64_t>(0);
+
+	int _pagemapFd = -1;
+	int _clearRefsFd = -1;
+	bool _ownsSoftDirty = false;
+	mutable std::vector<uint64_t> _pagemapBuffer;
+
+	// Pages in regions_of_interest, as a bitmap over trackedRanges
+	mutable std::vector<uint64_t> _roiBitmap;
+	mutable size_t _nRoiPages = 0;
+	mutable size_t _nRoiFolded = 0; // entries of regions_of_interest already in the bitmap
+
+	// MEMFD_REMAP: the sections after init, and the snapshot pages may still be mapped from
+	std::unique_ptr<LibSm64SnapshotFile> _originalFile;
+	// The DLL is destroyed last and still reads the mapped snapshot while it
+	// unloads. The pool is declared after this, so it is destroyed first and
+	// this snapshot's deleter then leaves its pages in place.
+	std::shared_ptr<const LibSm64SnapshotPool::Snapshot> _mappedSnapshot;
+	std::shared_ptr<LibSm64SnapshotPool> _snapshotPool;
+	std::vector<uint64_t> _remapBitmap;
+
+	// PAGE_DEDUP: pages of every slot in RAM
+	std::shared_ptr<LibSm64PageStore> _pageStore;
+
+	// Lightweight mode: once the profile is active it is _roiBitmap, and writes aren't tracked anymore
+	const bool _usesRegionProfile = config.lightweight && !config.incrementalSaves && config.savestates != LibSm64Savestates::MEMFD_REMAP;
+	bool _profileActive = false;
+	mutable uint64_t _profileVersion = 0; // bumped whenever the profile is activated or grows
+	int64_t _nWarmupFrames = 0;
+	mutable int64_t _nSavesSinceCheck = 0;
+
+	size_t GetPageIndex(const uint8_t* page) const;
+	uint8_t* GetPageAddress(size_t pageIndex) const;
+	bool MarkRoiPage(size_t pageIndex) const;
+	void UpdateRoiBitmap() const;
+	void ProtectTrackedRanges(int protection) const;
+	void CollectDirtyPages() const;
+	void ResetDirtyTracking() const;
+	const uint8_t* GetOriginalPage(const uint8_t* page) const;
+	std::shared_ptr<const LibSm64Page> CopyIncrementalPage(const uint8_t* page) const;
+	void SaveIncremental(LibSm64Mem& state) const;
+	void LoadIncremental(const LibSm64Mem& state);
+	void RemapTrackedRanges();
+	void StopTracking();
+	std::filesystem::path GetRegionProfilePath() const;
+	bool ReadRegionProfile();
+	void WriteRegionProfile() const;
+	void ActivateRegionProfile();
+	void CheckRegionProfile() const;
+	void SaveMemfd(LibSm64Mem& state) const;
+	void LoadMemfd(const LibSm64Mem& state);
+#endif
 };
 
 #endif
\ No newline at end of file
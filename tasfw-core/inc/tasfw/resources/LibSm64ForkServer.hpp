@@ -0,0 +1,102 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "tasfw/Resource.hpp"
+#include <tasfw/Inputs.hpp>
+
+#ifndef LIBSM64FORKSERVER_H
+#define LIBSM64FORKSERVER_H
+
+#if !defined(_WIN32)
+
+class LibSm64ForkServerConfig
+{
+public:
+	std::filesystem::path dllPath;
+	CountryCode countryCode;
+	int32_t maxSnapshots = 1024; // paused processes alive at once
+	int64_t snapshotCost = 256 * 1024; // estimated memory per snapshot, charged against the slot budget
+};
+
+class ForkServerProcesses;
+class ForkSnapshot;
+
+class LibSm64ForkMem
+{
+public:
+	// Paused process holding the state, or null for the state right after init.
+	// The process is killed when the last state referring to it goes away.
+	std::shared_ptr<const ForkSnapshot> snapshot;
+};
+
+// Runs libsm64 in helper processes and takes savestates with fork(): a save
+// pauses a copy-on-write child of the running process, and a load forks the
+// saved process to carry on from it.
+//
+// The library is also loaded here, at the same addresses, and its sections
+// mirror the running process lazily: after every state change a page is
+// fetched on its first access, and pages written here are sent back before
+// the next command. The pages of the controller pads and the global timer
+// come back with every state change instead.
+//
+// This process forks once, for a launcher that only forks the other helpers.
+// They inherit its memory, so create the resource before allocating much
+// else, and before other threads could hold locks the game needs.
+class LibSm64ForkServer final : public Resource<LibSm64ForkMem>
+{
+public:
+	SharedLib dll;
+	const LibSm64ForkServerConfig config;
+
+	LibSm64ForkServer(const LibSm64ForkServerConfig& config);
+	~LibSm64ForkServer();
+	void save(LibSm64ForkMem& state) const;
+	void load(const LibSm64ForkMem& state);
+	void advance();
+	void advanceFrames(std::span<const Inputs> inputs);
+	void* addr(const char* symbol) const;
+	std::size_t getStateSize(const LibSm64ForkMem&) const;
+	uint32_t getCurrentFrame() const { return *getSymbol<uint32_t>(GameSymbol::gGlobalTimer) - 1; }
+
+	// Called from the SIGSEGV handler. Returns false if the page isn't mirrored.
+	bool HandleFault(uint8_t* page) const;
+
+private:
+	enum class PageState : uint8_t
+	{
+		INVALID, // not fetched since the last state change
+		CLEAN,
+		DIRTY // written here since it was fetched
+	};
+
+	class PageRange
+	{
+	public:
+		uint8_t* begin;
+		uint8_t* end;
+		size_t firstPage;
+	};
+
+	void(TAS_FW_STDCALL* _sm64Update)() = nullptr;
+	std::vector<PageRange> _ranges;
+	size_t _nPages = 0;
+	std::shared_ptr<ForkServerProcesses> _processes;
+	int32_t _activeEntry = -1; // the running process
+	int32_t _rootEntry = -1; // paused right after init
+	mutable std::vector<PageState> _pageStates;
+	uint8_t* _controllerPads = nullptr;
+	std::vector<uint32_t> _eagerPages; // mirrored right after every state change
+
+	size_t GetPageIndex(const uint8_t* page) const;
+	uint8_t* GetPageAddress(size_t pageIndex) const;
+	void FlushDirtyPages() const;
+	void InvalidateMirror() const;
+	void SendEagerPages() const;
+	int32_t Fork(int32_t entry) const;
+	[[noreturn]] void Serve(int32_t entry) const;
+};
+
+#endif
+
+#endif
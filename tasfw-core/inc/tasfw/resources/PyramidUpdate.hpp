@@ -11,6 +11,7 @@ class PyramidUpdateConfig
 {
 public:
 	bool EnableMarioMovement = false;
+	std::filesystem::path saveCacheDirectory; // if set, LongLoad targets are cached here across runs
 
 	PyramidUpdateConfig() = default;
 };
@@ -110,20 +111,25 @@ private:
 	void AddStaticGeometry();
 };
 
-class PyramidUpdate : public Resource<PyramidUpdateMem>
+class PyramidUpdate final : public Resource<PyramidUpdateMem>
 {
 public:
 	PyramidUpdate();
-	PyramidUpdate(PyramidUpdateConfig config) : _enableMarioMovement(config.EnableMarioMovement) { }
+	PyramidUpdate(PyramidUpdateConfig config);
 	void save(PyramidUpdateMem& state) const;
 	void load(const PyramidUpdateMem& state);
 	void advance();
+	void advanceFrames(std::span<const Inputs> inputs);
 	void* addr(const char* symbol) const;
 	std::size_t getStateSize(const PyramidUpdateMem& state) const;
-	uint32_t getCurrentFrame() const;
+	uint32_t getCurrentFrame() const { return _state.frame; }
+	bool serialize(const PyramidUpdateMem& state, std::vector<uint8_t>& out) const;
+	bool deserialize(std::span<const uint8_t> in, PyramidUpdateMem& state) const;
+	uint64_t getPersistentKey() const;
 
 private:
 	PyramidUpdateMem _state;
+	void BindSymbols();
 	void UpdatePyramid();
 	void TransformSurfaces(int surfaceIndex);
 	float ApproachByIncrement(float goal, float src, float inc);
@@ -0,0 +1,255 @@
+#include <tasfw/CompressedSlotStore.hpp>
+
+#include <tasfw/Compression.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+
+static uint64_t hashPage(const uint8_t* page)
+{
+	uint64_t hash = 0x9e3779b97f4a7c15ull;
+	for (size_t i = 0; i < CompressedSlotStore::PAGE_SIZE; i += sizeof(uint64_t))
+	{
+		uint64_t word;
+		memcpy(&word, page + i, sizeof(uint64_t));
+		hash = (hash ^ word) * 0xff51afd7ed558ccdull;
+		hash ^= hash >> 32;
+	}
+
+	return hash;
+}
+
+static bool isZeroPage(const uint8_t* page)
+{
+	for (size_t i = 0; i < CompressedSlotStore::PAGE_SIZE; i += sizeof(uint64_t))
+	{
+		uint64_t word;
+		memcpy(&word, page + i, sizeof(uint64_t));
+		if (word != 0)
+			return false;
+	}
+
+	return true;
+}
+
+int64_t CompressedSlotStore::EntryOverhead(const Entry& entry) const
+{
+	return sizeof(Entry) + entry.pages.size() * sizeof(uint32_t);
+}
+
+void CompressedSlotStore::ExpandPage(const Page& page, uint8_t* out)
+{
+	if (!page.compressed)
+		memcpy(out, page.data.data(), PAGE_SIZE);
+	else if (!LzDecompress(page.data.data(), page.data.size(), out, PAGE_SIZE))
+		throw std::runtime_error("Corrupt page in compressed slot store.");
+}
+
+uint32_t CompressedSlotStore::StorePage(const uint8_t* page)
+{
+	if (isZeroPage(page))
+	{
+		_stats.nZeroPages++;
+		return ZERO_PAGE;
+	}
+
+	uint64_t hash = hashPage(page);
+	auto existing = _pagesByHash.find(hash);
+	if (existing != _pagesByHash.end())
+	{
+		// Hashes only nominate a candidate; the contents decide
+		Page& candidate = _pages[existing->second];
+		_pageBuffer.resize(PAGE_SIZE);
+		ExpandPage(candidate, _pageBuffer.data());
+		if (memcmp(_pageBuffer.data(), page, PAGE_SIZE) == 0)
+		{
+			candidate.nReferences++;
+			_stats.nDuplicatePages++;
+			return existing->second;
+		}
+	}
+
+	uint32_t pageIndex;
+	if (_freePages.empty())
+	{
+		pageIndex = static_cast<uint32_t>(_pages.size());
+		_pages.emplace_back();
+	}
+	else
+	{
+		pageIndex = _freePages.back();
+		_freePages.pop_back();
+	}
+
+	Page& stored = _pages[pageIndex];
+	_compressBuffer.resize(PAGE_SIZE);
+	size_t compressedSize = LzCompress(page, PAGE_SIZE, _compressBuffer.data(), PAGE_SIZE - 1);
+	stored.compressed = compressedSize != 0;
+	if (stored.compressed)
+		stored.data.assign(_compressBuffer.data(), _compressBuffer.data() + compressedSize);
+	else
+		stored.data.assign(page, page + PAGE_SIZE);
+	stored.hash = hash;
+	stored.nReferences = 1;
+
+	// Keep the first page seen for a hash; colliding pages are stored but not shared
+	_pagesByHash.try_emplace(hash, pageIndex);
+
+	_stats.nStoredPages++;
+	_stats.storedBytes += stored.data.size() + sizeof(Page);
+	return pageIndex;
+}
+
+void CompressedSlotStore::ReleasePage(uint32_t pageIndex)
+{
+	if (pageIndex == ZERO_PAGE)
+		return;
+
+	Page& page = _pages[pageIndex];
+	if (--page.nReferences != 0)
+		return;
+
+	auto indexed = _pagesByHash.find(page.hash);
+	if (indexed != _pagesByHash.end() && indexed->second == pageIndex)
+		_pagesByHash.erase(indexed);
+
+	_stats.nStoredPages--;
+	_stats.storedBytes -= page.data.size() + sizeof(Page);
+	page.data.clear();
+	page.data.shrink_to_fit();
+	_freePages.push_back(pageIndex);
+}
+
+void CompressedSlotStore::Unlink(int32_t key)
+{
+	Entry& entry = _entries[key];
+
+	if (entry.prev == -1)
+		_lruHead = entry.next;
+	else
+		_entries[entry.prev].next = entry.next;
+
+	if (entry.next == -1)
+		_lruTail = entry.prev;
+	else
+		_entries[entry.next].prev = entry.prev;
+
+	entry.prev = -1;
+	entry.next = -1;
+}
+
+void CompressedSlotStore::PushMostRecent(int32_t key)
+{
+	Entry& entry = _entries[key];
+	entry.prev = _lruTail;
+	entry.next = -1;
+
+	if (_lruTail == -1)
+		_lruHead = key;
+	else
+		_entries[_lruTail].next = key;
+
+	_lruTail = key;
+}
+
+void CompressedSlotStore::Insert(int32_t key, std::span<const uint8_t> data)
+{
+	if (key < 0)
+		throw std::runtime_error("Invalid compressed slot key " + std::to_string(key));
+
+	if (static_cast<size_t>(key) >= _entries.size())
+		_entries.resize(key + 1);
+	else if (_entries[key].present)
+		Erase(key);
+
+	uint64_t start = __rdtsc();
+
+	Entry& entry = _entries[key];
+	entry.rawSize = data.size();
+	entry.pages.clear();
+
+	for (size_t offset = 0; offset < data.size(); offset += PAGE_SIZE)
+	{
+		size_t length = (std::min)(PAGE_SIZE, data.size() - offset);
+		if (length == PAGE_SIZE)
+		{
+			entry.pages.push_back(StorePage(data.data() + offset));
+			continue;
+		}
+
+		// Pad the tail page with zeros
+		_tailBuffer.assign(PAGE_SIZE, 0);
+		memcpy(_tailBuffer.data(), data.data() + offset, length);
+		entry.pages.push_back(StorePage(_tailBuffer.data()));
+	}
+
+	entry.present = true;
+	PushMostRecent(key);
+
+	_stats.nEntries++;
+	_stats.nInserts++;
+	_stats.rawBytes += entry.rawSize;
+	_stats.storedBytes += EntryOverhead(entry);
+	_stats.compressTime += __rdtsc() - start;
+}
+
+bool CompressedSlotStore::Contains(int32_t key) const
+{
+	return key >= 0 && static_cast<size_t>(key) < _entries.size() && _entries[key].present;
+}
+
+void CompressedSlotStore::Read(int32_t key, std::vector<uint8_t>& out)
+{
+	if (!Contains(key))
+		throw std::runtime_error("Attempted to read missing compressed slot " + std::to_string(key));
+
+	uint64_t start = __rdtsc();
+
+	const Entry& entry = _entries[key];
+	out.resize(entry.pages.size() * PAGE_SIZE);
+	for (size_t i = 0; i < entry.pages.size(); i++)
+	{
+		uint8_t* page = out.data() + i * PAGE_SIZE;
+		if (entry.pages[i] == ZERO_PAGE)
+			memset(page, 0, PAGE_SIZE);
+		else
+			ExpandPage(_pages[entry.pages[i]], page);
+	}
+	out.resize(entry.rawSize);
+
+	if (key != _lruTail)
+	{
+		Unlink(key);
+		PushMostRecent(key);
+	}
+
+	_stats.nReads++;
+	_stats.decompressTime += __rdtsc() - start;
+}
+
+void CompressedSlotStore::Erase(int32_t key)
+{
+	if (!Contains(key))
+		return;
+
+	Entry& entry = _entries[key];
+	_stats.storedBytes -= EntryOverhead(entry);
+	_stats.rawBytes -= entry.rawSize;
+	_stats.nEntries--;
+
+	for (uint32_t pageIndex : entry.pages)
+		ReleasePage(pageIndex);
+
+	Unlink(key);
+	entry.pages.clear();
+	entry.rawSize = 0;
+	entry.present = false;
+}
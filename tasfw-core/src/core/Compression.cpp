@@ -0,0 +1,171 @@
+#include <tasfw/Compression.hpp>
+
+#include <cstring>
+
+static constexpr size_t MIN_MATCH = 4;
+static constexpr size_t MAX_OFFSET = 0xFFFF;
+static constexpr int HASH_BITS = 12;
+
+static inline uint32_t read32(const uint8_t* ptr)
+{
+	uint32_t value;
+	memcpy(&value, ptr, sizeof(uint32_t));
+	return value;
+}
+
+static inline uint32_t hashSequence(uint32_t sequence)
+{
+	return (sequence * 2654435761u) >> (32 - HASH_BITS);
+}
+
+// Writes the part of a length that doesn't fit in a token nibble
+static inline bool writeLength(uint8_t*& op, const uint8_t* opEnd, size_t length)
+{
+	while (length >= 255)
+	{
+		if (op >= opEnd)
+			return false;
+		*op++ = 255;
+		length -= 255;
+	}
+
+	if (op >= opEnd)
+		return false;
+	*op++ = static_cast<uint8_t>(length);
+	return true;
+}
+
+static inline bool readLength(const uint8_t*& ip, const uint8_t* ipEnd, size_t& length)
+{
+	uint8_t byte;
+	do
+	{
+		if (ip >= ipEnd)
+			return false;
+		byte = *ip++;
+		length += byte;
+	} while (byte == 255);
+
+	return true;
+}
+
+static bool writeSequence(
+	uint8_t*& op, const uint8_t* opEnd, const uint8_t* literals, size_t literalLength, size_t offset, size_t matchLength)
+{
+	if (op >= opEnd)
+		return false;
+
+	uint8_t* token = op++;
+	*token = static_cast<uint8_t>((literalLength >= 15 ? 15 : literalLength) << 4);
+	if (literalLength >= 15 && !writeLength(op, opEnd, literalLength - 15))
+		return false;
+
+	if (static_cast<size_t>(opEnd - op) < literalLength)
+		return false;
+	memcpy(op, literals, literalLength);
+	op += literalLength;
+
+	// The last sequence is literals only
+	if (matchLength == 0)
+		return true;
+
+	if (opEnd - op < 2)
+		return false;
+	*op++ = static_cast<uint8_t>(offset);
+	*op++ = static_cast<uint8_t>(offset >> 8);
+
+	size_t extraMatchLength = matchLength - MIN_MATCH;
+	*token |= static_cast<uint8_t>(extraMatchLength >= 15 ? 15 : extraMatchLength);
+	if (extraMatchLength >= 15 && !writeLength(op, opEnd, extraMatchLength - 15))
+		return false;
+
+	return true;
+}
+
+size_t LzCompress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstCapacity)
+{
+	// Positions are stored off by one so that 0 means "empty"
+	uint32_t table[1 << HASH_BITS] = {};
+
+	uint8_t* op = dst;
+	const uint8_t* opEnd = dst + dstCapacity;
+	size_t anchor = 0;
+	size_t position = 0;
+
+	while (srcSize >= MIN_MATCH && position <= srcSize - MIN_MATCH)
+	{
+		uint32_t sequence = read32(src + position);
+		uint32_t& entry = table[hashSequence(sequence)];
+		size_t candidate = entry;
+		entry = static_cast<uint32_t>(position + 1);
+
+		if (candidate == 0 || position - (candidate - 1) > MAX_OFFSET || read32(src + candidate - 1) != sequence)
+		{
+			position++;
+			continue;
+		}
+
+		candidate--;
+		size_t matchLength = MIN_MATCH;
+		while (position + matchLength < srcSize && src[candidate + matchLength] == src[position + matchLength])
+			matchLength++;
+
+		if (!writeSequence(op, opEnd, src + anchor, position - anchor, position - candidate, matchLength))
+			return 0;
+
+		position += matchLength;
+		anchor = position;
+	}
+
+	if (!writeSequence(op, opEnd, src + anchor, srcSize - anchor, 0, 0))
+		return 0;
+
+	return op - dst;
+}
+
+bool LzDecompress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstSize)
+{
+	const uint8_t* ip = src;
+	const uint8_t* ipEnd = src + srcSize;
+	uint8_t* op = dst;
+	uint8_t* opEnd = dst + dstSize;
+
+	while (ip < ipEnd)
+	{
+		uint8_t token = *ip++;
+
+		size_t literalLength = token >> 4;
+		if (literalLength == 15 && !readLength(ip, ipEnd, literalLength))
+			return false;
+
+		if (static_cast<size_t>(ipEnd - ip) < literalLength || static_cast<size_t>(opEnd - op) < literalLength)
+			return false;
+		memcpy(op, ip, literalLength);
+		ip += literalLength;
+		op += literalLength;
+
+		if (ip == ipEnd)
+			break;
+
+		if (ipEnd - ip < 2)
+			return false;
+		size_t offset = ip[0] | (static_cast<size_t>(ip[1]) << 8);
+		ip += 2;
+
+		size_t matchLength = token & 15;
+		if (matchLength == 15 && !readLength(ip, ipEnd, matchLength))
+			return false;
+		matchLength += MIN_MATCH;
+
+		if (offset == 0 || offset > static_cast<size_t>(op - dst) || static_cast<size_t>(opEnd - op) < matchLength)
+			return false;
+
+		// Matches may overlap their own output, so copy forwards byte by byte
+		const uint8_t* match = op - offset;
+		for (size_t i = 0; i < matchLength; i++)
+			op[i] = match[i];
+		op += matchLength;
+	}
+
+	return op == opEnd;
+}
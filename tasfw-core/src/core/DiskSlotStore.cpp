@@ -0,0 +1,335 @@
+#include <tasfw/DiskSlotStore.hpp>
+
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#include <intrin.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <x86intrin.h>
+#endif
+
+static constexpr int64_t EXTENT_ALIGNMENT = 4096;
+
+static int64_t alignExtent(int64_t size)
+{
+	return (size + EXTENT_ALIGNMENT - 1) & ~(EXTENT_ALIGNMENT - 1);
+}
+
+DiskSlotStore::DiskSlotStore(const std::filesystem::path& directory, int64_t capacity) :
+	_capacity(alignExtent(capacity))
+{
+	if (_capacity <= 0)
+		throw std::runtime_error("Disk slot store capacity must be positive.");
+
+#if defined(_WIN32)
+	wchar_t fileName[MAX_PATH];
+	if (GetTempFileNameW(directory.c_str(), L"tas", 0, fileName) == 0)
+		throw std::runtime_error("Failed to create spill file in " + directory.string());
+
+	_file = CreateFileW(fileName, GENERIC_READ | GENERIC_WRITE, 0, NULL, CREATE_ALWAYS,
+		FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE, NULL);
+	if (_file == INVALID_HANDLE_VALUE)
+		throw std::runtime_error("Failed to open spill file in " + directory.string());
+
+	_fileMapping = CreateFileMappingW(_file, NULL, PAGE_READWRITE,
+		static_cast<DWORD>(_capacity >> 32), static_cast<DWORD>(_capacity & 0xFFFFFFFF), NULL);
+	if (_fileMapping == NULL)
+	{
+		CloseHandle(_file);
+		throw std::runtime_error("Failed to map spill file.");
+	}
+
+	_mapping = static_cast<uint8_t*>(MapViewOfFile(_fileMapping, FILE_MAP_ALL_ACCESS, 0, 0, _capacity));
+	if (_mapping == NULL)
+	{
+		CloseHandle(_fileMapping);
+		CloseHandle(_file);
+		throw std::runtime_error("Failed to map spill file.");
+	}
+#else
+	std::string fileName = (directory / "tasfw-spill-XXXXXX").string();
+	_fd = mkstemp(fileName.data());
+	if (_fd == -1)
+		throw std::runtime_error("Failed to create spill file in " + directory.string());
+
+	// The file only needs to live as long as the descriptor
+	unlink(fileName.c_str());
+
+	if (ftruncate(_fd, _capacity) != 0)
+	{
+		close(_fd);
+		throw std::runtime_error("Failed to size spill file.");
+	}
+
+	void* mapping = mmap(NULL, _capacity, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+	if (mapping == MAP_FAILED)
+	{
+		close(_fd);
+		throw std::runtime_error("Failed to map spill file.");
+	}
+
+	_mapping = static_cast<uint8_t*>(mapping);
+#endif
+
+	_freeExtents[0] = _capacity;
+	_writer = std::thread(&DiskSlotStore::WriterLoop, this);
+}
+
+DiskSlotStore::~DiskSlotStore()
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stopping = true;
+	}
+	_cv.notify_all();
+	_writer.join();
+
+#if defined(_WIN32)
+	UnmapViewOfFile(_mapping);
+	CloseHandle(_fileMapping);
+	CloseHandle(_file);
+#else
+	munmap(_mapping, _capacity);
+	close(_fd);
+#endif
+}
+
+void DiskSlotStore::WriterLoop()
+{
+	std::unique_lock<std::mutex> lock(_mutex);
+	while (true)
+	{
+		_cv.wait(lock, [&]() { return _stopping || !_writeQueue.empty(); });
+		if (_stopping)
+			return;
+
+		int32_t key = _writeQueue.front();
+		_writeQueue.pop_front();
+
+		// Erased or already written
+		Entry& entry = _entries[key];
+		if (!entry.present || entry.pending.empty())
+			continue;
+
+		_inFlight = key;
+		const uint8_t* source = entry.pending.data();
+		uint8_t* destination = _mapping + entry.offset;
+		int64_t size = entry.size;
+		lock.unlock();
+
+		uint64_t start = __rdtsc();
+		memcpy(destination, source, size);
+#if defined(_WIN32)
+		FlushViewOfFile(destination, size);
+#else
+		msync(destination, alignExtent(size), MS_ASYNC);
+#endif
+		uint64_t elapsed = __rdtsc() - start;
+
+		lock.lock();
+		_inFlight = -1;
+		_entries[key].pending.clear();
+		_entries[key].pending.shrink_to_fit();
+		_stats.bytesWritten += size;
+		_stats.writeTime += elapsed;
+		_cv.notify_all();
+	}
+}
+
+void DiskSlotStore::WaitForWriter(std::unique_lock<std::mutex>& lock, int32_t key)
+{
+	_cv.wait(lock, [&]() { return _inFlight != key; });
+}
+
+int64_t DiskSlotStore::AllocateExtent(int64_t size)
+{
+	for (auto extent = _freeExtents.begin(); extent != _freeExtents.end(); extent++)
+	{
+		if (extent->second < size)
+			continue;
+
+		int64_t offset = extent->first;
+		int64_t remaining = extent->second - size;
+		_freeExtents.erase(extent);
+		if (remaining > 0)
+			_freeExtents[offset + size] = remaining;
+
+		return offset;
+	}
+
+	return -1;
+}
+
+void DiskSlotStore::FreeExtent(int64_t offset, int64_t size)
+{
+	auto next = _freeExtents.lower_bound(offset);
+	if (next != _freeExtents.end() && offset + size == next->first)
+	{
+		size += next->second;
+		next = _freeExtents.erase(next);
+	}
+
+	if (next != _freeExtents.begin())
+	{
+		auto previous = std::prev(next);
+		if (previous->first + previous->second == offset)
+		{
+			previous->second += size;
+			return;
+		}
+	}
+
+	_freeExtents[offset] = size;
+}
+
+void DiskSlotStore::Unlink(int32_t key)
+{
+	Entry& entry = _entries[key];
+
+	if (entry.prev == -1)
+		_lruHead = entry.next;
+	else
+		_entries[entry.prev].next = entry.next;
+
+	if (entry.next == -1)
+		_lruTail = entry.prev;
+	else
+		_entries[entry.next].prev = entry.prev;
+
+	entry.prev = -1;
+	entry.next = -1;
+}
+
+void DiskSlotStore::PushMostRecent(int32_t key)
+{
+	Entry& entry = _entries[key];
+	entry.prev = _lruTail;
+	entry.next = -1;
+
+	if (_lruTail == -1)
+		_lruHead = key;
+	else
+		_entries[_lruTail].next = key;
+
+	_lruTail = key;
+}
+
+bool DiskSlotStore::CanFit(size_t size) const
+{
+	int64_t needed = alignExtent(static_cast<int64_t>(size));
+	for (const auto& [offset, length] : _freeExtents)
+	{
+		if (length >= needed)
+			return true;
+	}
+
+	return false;
+}
+
+bool DiskSlotStore::Insert(int32_t key, std::span<const uint8_t> data)
+{
+	if (key < 0)
+		throw std::runtime_error("Invalid disk slot key " + std::to_string(key));
+
+	Erase(key);
+
+	std::unique_lock<std::mutex> lock(_mutex);
+
+	int64_t offset = AllocateExtent(alignExtent(data.size()));
+	if (offset == -1)
+		return false;
+
+	// Resizing moves the entries, but not the heap buffer the writer may be reading
+	if (static_cast<size_t>(key) >= _entries.size())
+		_entries.resize(key + 1);
+
+	Entry& entry = _entries[key];
+	entry.offset = offset;
+	entry.size = data.size();
+	entry.pending.assign(data.begin(), data.end());
+	entry.present = true;
+	PushMostRecent(key);
+
+	_stats.nEntries++;
+	_stats.nInserts++;
+	_stats.usedBytes += alignExtent(entry.size);
+
+	_writeQueue.push_back(key);
+	lock.unlock();
+	_cv.notify_all();
+
+	return true;
+}
+
+bool DiskSlotStore::Contains(int32_t key) const
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return key >= 0 && static_cast<size_t>(key) < _entries.size() && _entries[key].present;
+}
+
+void DiskSlotStore::Read(int32_t key, std::vector<uint8_t>& out)
+{
+	std::unique_lock<std::mutex> lock(_mutex);
+	if (key < 0 || static_cast<size_t>(key) >= _entries.size() || !_entries[key].present)
+		throw std::runtime_error("Attempted to read missing disk slot " + std::to_string(key));
+
+	uint64_t start = __rdtsc();
+
+	Entry& entry = _entries[key];
+	out.resize(entry.size);
+	if (!entry.pending.empty())
+	{
+		memcpy(out.data(), entry.pending.data(), entry.size);
+		_stats.nPendingReads++;
+	}
+	else
+		memcpy(out.data(), _mapping + entry.offset, entry.size);
+
+	if (key != _lruTail)
+	{
+		Unlink(key);
+		PushMostRecent(key);
+	}
+
+	_stats.nReads++;
+	_stats.bytesRead += entry.size;
+	_stats.readTime += __rdtsc() - start;
+}
+
+void DiskSlotStore::Erase(int32_t key)
+{
+	std::unique_lock<std::mutex> lock(_mutex);
+	if (key < 0 || static_cast<size_t>(key) >= _entries.size() || !_entries[key].present)
+		return;
+
+	WaitForWriter(lock, key);
+
+	Entry& entry = _entries[key];
+	Unlink(key);
+	FreeExtent(entry.offset, alignExtent(entry.size));
+	_stats.nEntries--;
+	_stats.usedBytes -= alignExtent(entry.size);
+
+	entry.pending.clear();
+	entry.pending.shrink_to_fit();
+	entry.present = false;
+
+#if !defined(_WIN32)
+	// Let the kernel drop the stale pages instead of writing them back
+	madvise(_mapping + entry.offset, alignExtent(entry.size), MADV_REMOVE);
+#endif
+}
+
+DiskSlotStore::Stats DiskSlotStore::GetStats() const
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _stats;
+}
@@ -0,0 +1,174 @@
+#include <tasfw/FrameMap.hpp>
+
+#include <algorithm>
+#include <bit>
+
+bool FrameSet::Insert(int64_t frame)
+{
+	int64_t wordBase = frame & ~int64_t(63);
+	if (_words.empty())
+		_base = wordBase;
+	else if (wordBase < _base)
+	{
+		size_t shift = size_t((_base - wordBase) / 64);
+		_words.insert(_words.begin(), shift, 0);
+		_base = wordBase;
+	}
+
+	size_t index = size_t(frame - _base);
+	if (index / 64 >= _words.size())
+		_words.resize(index / 64 + 1, 0);
+
+	uint64_t bit = 1ull << (index % 64);
+	if (_words[index / 64] & bit)
+		return false;
+
+	_words[index / 64] |= bit;
+	_count++;
+	return true;
+}
+
+void FrameSet::InsertRange(int64_t first, int64_t count)
+{
+	if (count <= 0)
+		return;
+
+	// Sizes and rebases the bitmap for both ends
+	Insert(first);
+	Insert(first + count - 1);
+
+	uint64_t begin = uint64_t(first - _base);
+	uint64_t last = begin + uint64_t(count) - 1;
+	for (size_t word = size_t(begin / 64); word <= size_t(last / 64); word++)
+	{
+		uint64_t low = word == begin / 64 ? begin % 64 : 0;
+		uint64_t high = word == last / 64 ? last % 64 : 63;
+		uint64_t mask = (~0ull >> (63 - high)) & (~0ull << low);
+		_count += std::popcount(mask & ~_words[word]);
+		_words[word] |= mask;
+	}
+}
+
+void FrameSet::Erase(int64_t frame)
+{
+	if (!Contains(frame))
+		return;
+
+	uint64_t index = uint64_t(frame - _base);
+	_words[index / 64] &= ~(1ull << (index % 64));
+	_count--;
+}
+
+void FrameSet::EraseFrom(int64_t frame)
+{
+	if (_count == 0)
+		return;
+
+	if (frame <= _base)
+	{
+		Clear();
+		return;
+	}
+
+	uint64_t index = uint64_t(frame - _base);
+	size_t word = size_t(index / 64);
+	if (word >= _words.size())
+		return;
+
+	for (size_t i = word + 1; i < _words.size(); i++)
+		_count -= std::popcount(_words[i]);
+
+	uint64_t keep = (1ull << (index % 64)) - 1;
+	_count -= std::popcount(_words[word] & ~keep);
+	_words[word] &= keep;
+	_words.resize(word + 1);
+}
+
+void FrameSet::EraseBefore(int64_t frame)
+{
+	if (_count == 0 || frame <= _base)
+		return;
+
+	uint64_t index = uint64_t(frame - _base);
+	size_t fullWords = size_t((std::min)(index / 64, uint64_t(_words.size())));
+	for (size_t i = 0; i < fullWords; i++)
+	{
+		_count -= std::popcount(_words[i]);
+		_words[i] = 0;
+	}
+
+	if (fullWords < _words.size())
+	{
+		uint64_t mask = (1ull << (index % 64)) - 1;
+		_count -= std::popcount(_words[fullWords] & mask);
+		_words[fullWords] &= ~mask;
+	}
+}
+
+void FrameSet::Clear()
+{
+	_words.clear();
+	_count = 0;
+}
+
+int64_t FrameSet::FindLatest(int64_t frame) const
+{
+	if (_count == 0 || frame < _base)
+		return NONE;
+
+	uint64_t index = uint64_t(frame - _base);
+	int64_t word = int64_t(index / 64);
+	uint64_t mask = (2ull << (index % 64)) - 1; // wraps to all bits for bit 63
+	if (word >= int64_t(_words.size()))
+	{
+		word = int64_t(_words.size()) - 1;
+		mask = ~0ull;
+	}
+
+	for (; word >= 0; word--, mask = ~0ull)
+	{
+		uint64_t bits = _words[word] & mask;
+		if (bits)
+			return _base + word * 64 + 63 - std::countl_zero(bits);
+	}
+
+	return NONE;
+}
+
+int64_t FrameSet::FindNext(int64_t frame) const
+{
+	if (_count == 0)
+		return NONE;
+
+	uint64_t index = frame < _base ? 0 : uint64_t(frame - _base);
+	size_t word = size_t(index / 64);
+	if (word >= _words.size())
+		return NONE;
+
+	for (uint64_t mask = ~0ull << (index % 64); word < _words.size(); word++, mask = ~0ull)
+	{
+		uint64_t bits = _words[word] & mask;
+		if (bits)
+			return _base + int64_t(word) * 64 + std::countr_zero(bits);
+	}
+
+	return NONE;
+}
+
+int64_t FrameSet::FindNextAbsent(int64_t frame) const
+{
+	int64_t end = _base + int64_t(_words.size()) * 64;
+	if (frame < _base || frame >= end)
+		return frame;
+
+	uint64_t index = uint64_t(frame - _base);
+	size_t word = size_t(index / 64);
+	for (uint64_t mask = ~0ull << (index % 64); word < _words.size(); word++, mask = ~0ull)
+	{
+		uint64_t gaps = ~_words[word] & mask;
+		if (gaps)
+			return _base + int64_t(word) * 64 + std::countr_zero(gaps);
+	}
+
+	return end;
+}
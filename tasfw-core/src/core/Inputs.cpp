@@ -4,6 +4,7 @@
 #include <system_error>
 #include <sm64/Trig.hpp>
 
+#include <algorithm>
 #include <cmath>
 #include <iostream>
 #include <fstream>
@@ -313,6 +314,82 @@ bool Inputs::HauEquals(int16_t angle1, int16_t angle2)
 	return hau1 == hau2;
 }
 
+// Must be called once the frames are in the bitmap, which fixes its base
+Inputs* InputTimeline::GetStorage(int64_t firstFrame, size_t count)
+{
+	int64_t base = _frames.GetBase();
+	if (_inputs.empty())
+		_inputsBase = base;
+	else if (base < _inputsBase)
+	{
+		_inputs.insert(_inputs.begin(), size_t(_inputsBase - base), Inputs());
+		_inputsBase = base;
+	}
+
+	size_t index = size_t(firstFrame - base);
+	if (index + count > _inputs.size())
+		_inputs.resize(index + count);
+
+	return &_inputs[index];
+}
+
+void InputTimeline::Set(int64_t frame, Inputs inputs)
+{
+	_frames.Insert(frame);
+	*GetStorage(frame, 1) = inputs;
+}
+
+void InputTimeline::SetRange(int64_t firstFrame, std::span<const Inputs> inputs)
+{
+	if (inputs.empty())
+		return;
+
+	_frames.InsertRange(firstFrame, int64_t(inputs.size()));
+	std::copy(inputs.begin(), inputs.end(), GetStorage(firstFrame, inputs.size()));
+}
+
+void InputTimeline::Merge(const InputTimeline& other, bool overwrite)
+{
+	if (this == &other)
+		return;
+
+	other.ForEachSpan([&](int64_t firstFrame, std::span<const Inputs> inputs)
+	{
+		if (overwrite)
+		{
+			SetRange(firstFrame, inputs);
+			return;
+		}
+
+		for (size_t i = 0; i < inputs.size(); i++)
+		{
+			if (!Contains(firstFrame + int64_t(i)))
+				Set(firstFrame + int64_t(i), inputs[i]);
+		}
+	});
+}
+
+void InputTimeline::EraseFrom(int64_t frame)
+{
+	_frames.EraseFrom(frame);
+	if (_frames.Empty())
+		_inputs.clear();
+	else if (frame - _inputsBase < int64_t(_inputs.size()))
+		_inputs.resize(size_t(frame - _inputsBase));
+}
+
+void InputTimeline::EraseBefore(int64_t frame)
+{
+	// The storage below stays in place, it is reused if those frames come back
+	_frames.EraseBefore(frame);
+}
+
+void InputTimeline::Clear()
+{
+	_frames.Clear();
+	_inputs.clear();
+}
+
 int M64::load()
 {
 	std::ifstream f(fileName.c_str(), ios_base::binary);
@@ -350,7 +427,7 @@ int M64::load()
 			f.read(reinterpret_cast<char*>(&stick_y), sizeof(uint8_t));
 			if (f.eof()) break;
 
-			frames[index] = Inputs(buttons, stick_x, stick_y);
+			frames.Set(index, Inputs(buttons, stick_x, stick_y));
 			index++;
 		}
 	}
@@ -368,7 +445,7 @@ int M64::save(long initFrame)
 	if (fileName.empty())
 		return 0;
 
-	if (frames.empty())
+	if (frames.Empty())
 		return 1;
 
 	std::ofstream f;
@@ -381,7 +458,7 @@ int M64::save(long initFrame)
 	f.exceptions(ios_base::failbit | ios_base::badbit);
 
 
-	uint64_t lastFrame = frames.rbegin()->first;
+	uint64_t lastFrame = frames.Last();
 
 	try
 	{
@@ -418,11 +495,11 @@ int M64::save(long initFrame)
 			int8_t stickX = 0;
 			int8_t stickY = 0;
 
-			if (frames.contains(i))
+			if (const Inputs* inputs = frames.Find(i))
 			{
-				bigEndianButtons = byteswap(frames[i].buttons);
-				stickX = frames[i].stick_x;
-				stickY = frames[i].stick_y;
+				bigEndianButtons = byteswap(inputs->buttons);
+				stickX = inputs->stick_x;
+				stickY = inputs->stick_y;
 			}
 
 			f.write(reinterpret_cast<char*>(&bigEndianButtons), sizeof(uint16_t));
@@ -0,0 +1,199 @@
+#include <tasfw/PersistentSaveCache.hpp>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+static constexpr char MAGIC[8] = {'T', 'A', 'S', 'F', 'W', 'S', 'V', '1'};
+
+class SaveFileHeader
+{
+public:
+	char magic[8];
+	int64_t frame;
+	uint64_t inputPrefixHash;
+	uint64_t size;
+	uint64_t contentHash;
+};
+
+static std::string toHex(uint64_t value)
+{
+	char buffer[17];
+	snprintf(buffer, sizeof(buffer), "%016llx", static_cast<unsigned long long>(value));
+	return buffer;
+}
+
+uint64_t PersistentSaveCache::HashBytes(const void* data, size_t size, uint64_t seed)
+{
+	// FNV-1a over 8-byte words, with a final avalanche
+	const uint8_t* bytes = static_cast<const uint8_t*>(data);
+	uint64_t hash = seed;
+
+	size_t i = 0;
+	for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t))
+	{
+		uint64_t word;
+		memcpy(&word, bytes + i, sizeof(uint64_t));
+		hash = (hash ^ word) * 0x100000001b3ull;
+	}
+
+	for (; i < size; i++)
+		hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+
+	hash ^= hash >> 33;
+	hash *= 0xff51afd7ed558ccdull;
+	hash ^= hash >> 33;
+	return hash;
+}
+
+uint64_t PersistentSaveCache::HashFile(const std::filesystem::path& path)
+{
+	std::ifstream stream(path, std::ios::binary);
+	if (!stream.is_open())
+		throw std::runtime_error("Failed to open " + path.string() + " for hashing.");
+
+	std::vector<char> buffer(1 << 20);
+	uint64_t hash = 0xcbf29ce484222325ull;
+	while (stream)
+	{
+		stream.read(buffer.data(), buffer.size());
+		if (stream.gcount() > 0)
+			hash = HashBytes(buffer.data(), stream.gcount(), hash);
+	}
+
+	return hash;
+}
+
+PersistentSaveCache::PersistentSaveCache(const std::filesystem::path& directory, uint64_t resourceKey) :
+	_directory(directory / toHex(resourceKey))
+{
+	std::filesystem::create_directories(_directory);
+
+	for (const auto& file : std::filesystem::directory_iterator(_directory))
+	{
+		if (!file.is_regular_file() || file.path().extension() != ".sav")
+			continue;
+
+		unsigned long long frame, inputPrefixHash;
+		if (sscanf(file.path().stem().string().c_str(), "%llu-%llx", &frame, &inputPrefixHash) == 2)
+			_entries[frame].insert(inputPrefixHash);
+	}
+}
+
+std::filesystem::path PersistentSaveCache::GetEntryPath(int64_t frame, uint64_t inputPrefixHash) const
+{
+	return _directory / (std::to_string(frame) + "-" + toHex(inputPrefixHash) + ".sav");
+}
+
+bool PersistentSaveCache::Contains(int64_t frame, uint64_t inputPrefixHash) const
+{
+	auto entry = _entries.find(frame);
+	return entry != _entries.end() && entry->second.contains(inputPrefixHash);
+}
+
+std::vector<int64_t> PersistentSaveCache::GetFrames(int64_t minFrame, int64_t maxFrame) const
+{
+	std::vector<int64_t> frames;
+	for (auto entry = _entries.upper_bound(maxFrame); entry != _entries.begin();)
+	{
+		entry--;
+		if (entry->first < minFrame)
+			break;
+
+		frames.push_back(entry->first);
+	}
+
+	return frames;
+}
+
+bool PersistentSaveCache::Read(int64_t frame, uint64_t inputPrefixHash, std::vector<uint8_t>& out)
+{
+	if (!Contains(frame, inputPrefixHash))
+		return false;
+
+	std::filesystem::path path = GetEntryPath(frame, inputPrefixHash);
+	std::ifstream stream(path, std::ios::binary);
+
+	SaveFileHeader header;
+	bool valid = stream.read(reinterpret_cast<char*>(&header), sizeof(header))
+		&& memcmp(header.magic, MAGIC, sizeof(MAGIC)) == 0
+		&& header.frame == frame
+		&& header.inputPrefixHash == inputPrefixHash;
+
+	if (valid)
+	{
+		out.resize(header.size);
+		valid = stream.read(reinterpret_cast<char*>(out.data()), header.size)
+			&& HashBytes(out.data(), out.size()) == header.contentHash;
+	}
+
+	if (!valid)
+	{
+		// Truncated or foreign file; forget it so it gets rewritten
+		stream.close();
+		Erase(frame, inputPrefixHash);
+		nMisses++;
+		return false;
+	}
+
+	nHits++;
+	return true;
+}
+
+void PersistentSaveCache::Erase(int64_t frame, uint64_t inputPrefixHash)
+{
+	std::error_code error;
+	std::filesystem::remove(GetEntryPath(frame, inputPrefixHash), error);
+
+	auto entry = _entries.find(frame);
+	if (entry == _entries.end())
+		return;
+
+	entry->second.erase(inputPrefixHash);
+	if (entry->second.empty())
+		_entries.erase(entry);
+}
+
+void PersistentSaveCache::Write(int64_t frame, uint64_t inputPrefixHash, std::span<const uint8_t> data)
+{
+	std::filesystem::path path = GetEntryPath(frame, inputPrefixHash);
+
+	// Write under a unique name and rename, so that concurrent runs sharing
+	// the directory never observe a partial file
+	static thread_local std::mt19937_64 rng(std::random_device {}());
+	std::filesystem::path temporaryPath = path;
+	temporaryPath += "." + toHex(rng()) + ".tmp";
+
+	SaveFileHeader header;
+	memcpy(header.magic, MAGIC, sizeof(MAGIC));
+	header.frame = frame;
+	header.inputPrefixHash = inputPrefixHash;
+	header.size = data.size();
+	header.contentHash = HashBytes(data.data(), data.size());
+
+	{
+		std::ofstream stream(temporaryPath, std::ios::binary | std::ios::trunc);
+		if (!stream.write(reinterpret_cast<const char*>(&header), sizeof(header))
+			|| !stream.write(reinterpret_cast<const char*>(data.data()), data.size()))
+		{
+			stream.close();
+			std::error_code error;
+			std::filesystem::remove(temporaryPath, error);
+			return;
+		}
+	}
+
+	std::error_code error;
+	std::filesystem::rename(temporaryPath, path, error);
+	if (error)
+	{
+		std::filesystem::remove(temporaryPath, error);
+		return;
+	}
+
+	_entries[frame].insert(inputPrefixHash);
+	nWrites++;
+}
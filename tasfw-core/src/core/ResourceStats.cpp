@@ -0,0 +1,67 @@
+#include <tasfw/ResourceStats.hpp>
+
+#include <algorithm>
+#include <chrono>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+
+uint64_t LatencyHistogram::GetBucketUpperBound(size_t bucket)
+{
+	if (bucket < (1u << SUB_BUCKET_BITS))
+		return bucket;
+
+	int shift = int(bucket >> SUB_BUCKET_BITS) - 1;
+	uint64_t lower = ((1ull << SUB_BUCKET_BITS) + (bucket & ((1u << SUB_BUCKET_BITS) - 1))) << shift;
+	return lower + (1ull << shift) - 1;
+}
+
+uint64_t LatencyHistogram::Quantile(double q) const
+{
+	if (count == 0)
+		return 0;
+
+	uint64_t rank = uint64_t(q * double(count - 1)) + 1;
+	uint64_t seen = 0;
+	for (size_t bucket = 0; bucket < N_BUCKETS; bucket++)
+	{
+		seen += _buckets[bucket];
+		if (seen >= rank)
+			return (std::min)(GetBucketUpperBound(bucket), maxNs);
+	}
+
+	return maxNs;
+}
+
+void LatencyHistogram::WriteJson(std::ostream& out) const
+{
+	out << "{\"count\": " << count
+		<< ", \"mean_ns\": " << uint64_t(MeanNs())
+		<< ", \"p50_ns\": " << Quantile(0.5)
+		<< ", \"p90_ns\": " << Quantile(0.9)
+		<< ", \"p99_ns\": " << Quantile(0.99)
+		<< ", \"max_ns\": " << maxNs << "}";
+}
+
+// Busy-waits a few milliseconds the first time, which is negligible next to
+// loading a resource
+double GetNanosecondsPerTick()
+{
+	static const double nsPerTick = []()
+	{
+		using clock = std::chrono::steady_clock;
+
+		auto start = clock::now();
+		uint64_t startTicks = __rdtsc();
+		while (clock::now() - start < std::chrono::milliseconds(5)) { }
+		uint64_t ticks = __rdtsc() - startTicks;
+		auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start).count();
+
+		return ticks ? double(ns) / double(ticks) : 1.0;
+	}();
+
+	return nsPerTick;
+}
@@ -0,0 +1,145 @@
+#include <tasfw/SaveMemoryGovernor.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+int64_t SaveMemoryGovernor::Share::Report(uint64_t hits, uint64_t misses)
+{
+	nHits.store(hits, std::memory_order_relaxed);
+	nMisses.store(misses, std::memory_order_relaxed);
+
+	SaveMemoryGovernor& governor = *_governor;
+	if ((governor._nReports.fetch_add(1, std::memory_order_relaxed) + 1) % governor.rebalanceInterval == 0)
+	{
+		// Another thread rebalancing already covers this report
+		std::unique_lock lock(governor._mutex, std::try_to_lock);
+		if (lock.owns_lock())
+			governor.RebalanceLocked();
+	}
+
+	return limit.load(std::memory_order_relaxed);
+}
+
+SaveMemoryGovernor& SaveMemoryGovernor::Global()
+{
+	static SaveMemoryGovernor governor;
+	return governor;
+}
+
+void SaveMemoryGovernor::SetBudget(int64_t budget)
+{
+	if (budget < 0)
+		throw std::runtime_error("Save memory budget must not be negative.");
+
+	if (budget == 0)
+	{
+		budget = GetAvailableMemory() / 2;
+		if (budget == 0)
+			throw std::runtime_error("Unable to determine available memory, configure a save memory budget.");
+	}
+
+	std::lock_guard lock(_mutex);
+	_budget.store(budget, std::memory_order_relaxed);
+	RebalanceLocked();
+}
+
+std::shared_ptr<SaveMemoryGovernor::Share> SaveMemoryGovernor::Register()
+{
+	if (GetBudget() == 0)
+		SetBudget(0);
+
+	auto share = std::make_shared<Share>();
+	share->_governor = this;
+
+	std::lock_guard lock(_mutex);
+	_shares.push_back(share);
+	RebalanceLocked();
+
+	return share;
+}
+
+void SaveMemoryGovernor::Rebalance()
+{
+	std::lock_guard lock(_mutex);
+	RebalanceLocked();
+}
+
+void SaveMemoryGovernor::RebalanceLocked()
+{
+	std::erase_if(_shares, [](const std::shared_ptr<Share>& share) { return share.use_count() == 1; });
+	if (_shares.empty())
+		return;
+
+	double totalWeight = 0;
+	for (auto& share : _shares)
+	{
+		uint64_t hits = share->nHits.load(std::memory_order_relaxed);
+		uint64_t misses = share->nMisses.load(std::memory_order_relaxed);
+		uint64_t newHits = hits - share->_lastHits;
+		uint64_t newMisses = misses - share->_lastMisses;
+		share->_lastHits = hits;
+		share->_lastMisses = misses;
+
+		// Smoothed, so one unlucky interval doesn't swing the split
+		if (newHits + newMisses != 0)
+		{
+			double missRate = double(newMisses) / double(newHits + newMisses);
+			share->_weight = 0.5 * share->_weight + 0.5 * (1 + 3 * missRate);
+		}
+
+		totalWeight += share->_weight;
+	}
+
+	int64_t budget = GetBudget();
+	int64_t floor = budget / int64_t(2 * _shares.size());
+	double flexible = double(budget - floor * int64_t(_shares.size()));
+	for (auto& share : _shares)
+	{
+		int64_t limit = floor + int64_t(flexible * share->_weight / totalWeight);
+		share->limit.store((std::max)(limit, minShare), std::memory_order_relaxed);
+	}
+}
+
+#if defined(_WIN32)
+
+int64_t SaveMemoryGovernor::GetAvailableMemory()
+{
+	MEMORYSTATUSEX status = {};
+	status.dwLength = sizeof(status);
+	if (!GlobalMemoryStatusEx(&status))
+		return 0;
+
+	return int64_t(status.ullAvailPhys);
+}
+
+#else
+
+int64_t SaveMemoryGovernor::GetAvailableMemory()
+{
+	// MemAvailable counts reclaimable page cache, unlike _SC_AVPHYS_PAGES
+	std::ifstream meminfo("/proc/meminfo");
+	std::string key;
+	int64_t kib;
+	while (meminfo >> key >> kib)
+	{
+		if (key == "MemAvailable:")
+			return kib * 1024;
+
+		meminfo.ignore(64, '\n');
+	}
+
+	long pages = sysconf(_SC_AVPHYS_PAGES);
+	long pageSize = sysconf(_SC_PAGESIZE);
+	return pages > 0 && pageSize > 0 ? int64_t(pages) * pageSize : 0;
+}
+
+#endif
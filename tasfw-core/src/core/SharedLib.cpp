@@ -5,24 +5,68 @@
 #include <fstream>
 #include <iostream>
 #include <memory>
+#include <mutex>
 #include <stdexcept>
 #include <string>
 #include <system_error>
 #include <unordered_map>
+#include <vector>
+
+// File contents of libraries loaded as isolated instances, so that loading
+// the Nth instance doesn't read the file again
+static std::shared_ptr<const std::vector<char>> readLibraryImage(const std::filesystem::path& fileName)
+{
+	static std::mutex mutex;
+	static std::unordered_map<std::string, std::shared_ptr<const std::vector<char>>> images;
+
+	std::lock_guard lock(mutex);
+	auto& image = images[std::filesystem::absolute(fileName).string()];
+	if (!image)
+	{
+		std::ifstream file(fileName, std::ios_base::binary);
+		if (!file)
+			throw std::runtime_error("Failed to read " + fileName.string());
+		image = std::make_shared<const std::vector<char>>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	}
+
+	return image;
+}
 
 #if defined(_WIN32)
 #define NOMINMAX
 	#include <windows.h>
 
-SharedLib::SharedLib(const std::filesystem::path& fileName) :
+SharedLib::SharedLib(const std::filesystem::path& fileName, bool isolated) :
 	libFileName(fileName.string()),
+	isolatedCopy(
+		[&]() -> std::filesystem::path
+		{
+	if (!isolated)
+		return {};
+
+	// LoadLibrary shares a module per path, so load a uniquely named copy
+	wchar_t tempDir[MAX_PATH + 1];
+	wchar_t tempFile[MAX_PATH + 1];
+	if (!GetTempPathW(MAX_PATH + 1, tempDir) || !GetTempFileNameW(tempDir, L"tfw", 0, tempFile))
+		throw std::system_error(GetLastError(), std::system_category());
+
+	auto image = readLibraryImage(fileName);
+	std::ofstream file(tempFile, std::ios_base::binary | std::ios_base::trunc);
+	file.write(image->data(), image->size());
+	if (!file)
+		throw std::runtime_error("Failed to copy " + fileName.string());
+
+	return std::filesystem::path(tempFile);
+		}()),
 	handle(
 		[&]() -> HMODULE
 		{
-	HMODULE res = LoadLibraryW(fileName.c_str());
+	HMODULE res = LoadLibraryW(isolated ? isolatedCopy.c_str() : fileName.c_str());
 	if (res == nullptr)
 	{
 		DWORD lastError = GetLastError();
+		if (isolated)
+			DeleteFileW(isolatedCopy.c_str());
 		throw std::system_error(lastError, std::system_category());
 	}
 	return res;
@@ -40,6 +84,12 @@ SharedLib::~SharedLib()
 		std::cerr << "terminating...\n";
 		std::terminate();
 	}
+
+	if (!isolatedCopy.empty())
+	{
+		std::error_code error;
+		std::filesystem::remove(isolatedCopy, error);
+	}
 }
 
 void* SharedLib::get(const char* symbol) const
@@ -129,15 +179,47 @@ std::unordered_map<std::string, SectionInfo> SharedLib::readSections()
 	#include <dlfcn.h>
 	#include <elf.h>
 	#include <link.h>
+	#include <sys/mman.h>
+	#include <unistd.h>
 
-SharedLib::SharedLib(const std::filesystem::path& fileName) :
+SharedLib::SharedLib(const std::filesystem::path& fileName, bool isolated) :
 	libFileName(fileName.string()),
+	memfd(
+		[&]() -> int
+		{
+	if (!isolated)
+		return -1;
+
+	// dlopen shares an object per path and inode, and every memfd is a new inode
+	int fd = memfd_create(fileName.filename().c_str(), MFD_CLOEXEC);
+	if (fd == -1)
+		throw std::system_error(errno, std::system_category());
+
+	auto image = readLibraryImage(fileName);
+	for (size_t written = 0; written < image->size();)
+	{
+		ssize_t n = write(fd, image->data() + written, image->size() - written);
+		if (n <= 0)
+		{
+			close(fd);
+			throw std::system_error(errno, std::system_category());
+		}
+		written += n;
+	}
+
+	return fd;
+		}()),
 	handle(
 		[&]() -> void*
 		{
-	void* res = dlopen(fileName.c_str(), RTLD_NOW);
+	if (memfd != -1)
+		libFileName = "/proc/self/fd/" + std::to_string(memfd);
+
+	void* res = dlopen(libFileName.c_str(), RTLD_NOW);
 	if (res == nullptr)
 	{
+		if (memfd != -1)
+			close(memfd);
 		throw std::runtime_error(dlerror());
 	}
 	return res;
@@ -153,6 +235,9 @@ SharedLib::~SharedLib()
 		std::cerr << "terminating...\n";
 		std::terminate();
 	}
+
+	if (memfd != -1)
+		close(memfd);
 }
 void* SharedLib::get(const char* symbol) const
 {
@@ -1,6 +1,16 @@
 #include "tasfw/resources/LibSm64.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <fstream>
+#include <mutex>
+
 #if !defined(_WIN32)
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#include <fcntl.h>
 #include <sys/mman.h>
 #include <signal.h>
 #include <unistd.h>
@@ -15,24 +25,275 @@ static void* align_pointer(void* ptr, intptr_t alignment) {
 	return reinterpret_cast<void*>(x);
 }
 
-std::vector<uint8_t*> regions_of_interest;
+// Instances under the write trap, so that a fault is routed to the instance
+// owning the page. Only constructors and destructors write to this, and each
+// instance's list is only appended to by faults on the thread using it.
+static constexpr size_t MAX_TRACKED_INSTANCES = 256;
+static std::atomic<LibSm64*> trackedInstances[MAX_TRACKED_INSTANCES];
+static struct sigaction previousSegvAction;
+static std::once_flag segvHandlerInstalled;
+
+// Soft-dirty bits are cleared process-wide, which would lose other instances' pages
+static std::atomic<bool> softDirtyInUse = false;
+
+static void handler(int sig, siginfo_t* si, void* context)
+{
+	uint8_t* page = static_cast<uint8_t*>(align_pointer(si->si_addr, pagesize));
+	for (const std::atomic<LibSm64*>& entry : trackedInstances)
+	{
+		LibSm64* instance = entry.load(std::memory_order_acquire);
+		if (!instance)
+			continue;
+
+		for (const LibSm64::TrackedRange& range : instance->trackedRanges)
+		{
+			if (page < range.begin || page >= range.end)
+				continue;
+
+			// Capacity is reserved up front, so this never allocates
+			mprotect(page, pagesize, PROT_READ | PROT_EXEC | PROT_WRITE);
+			instance->regions_of_interest.push_back(page);
+			return;
+		}
+	}
+
+	// Not a tracked page: a real crash, or someone else's trap
+	if (previousSegvAction.sa_flags & SA_SIGINFO)
+		previousSegvAction.sa_sigaction(sig, si, context);
+	else if (previousSegvAction.sa_handler != SIG_DFL && previousSegvAction.sa_handler != SIG_IGN)
+		previousSegvAction.sa_handler(sig);
+	else
+		signal(SIGSEGV, SIG_DFL); // the faulting instruction reruns and takes the default action
+}
+
+static constexpr uint64_t REGION_PROFILE_VERSION = 1;
 
-static void handler(int sig, siginfo_t* si, void* unused)
+static constexpr uint64_t PAGEMAP_SOFT_DIRTY = 1ull << 55;
+
+static bool clearSoftDirty(int clearRefsFd)
+{
+	return pwrite(clearRefsFd, "4", 1, 0) == 1;
+}
+
+static bool isSoftDirty(int pagemapFd, const void* page)
+{
+	uint64_t entry = 0;
+	off_t offset = (reinterpret_cast<uintptr_t>(page) / pagesize) * sizeof(uint64_t);
+	return pread(pagemapFd, &entry, sizeof(entry), offset) == sizeof(entry) && (entry & PAGEMAP_SOFT_DIRTY);
+}
+
+// Kernels without CONFIG_MEM_SOFT_DIRTY accept clear_refs but never set the bit
+static bool softDirtyWorks(int clearRefsFd, int pagemapFd)
 {
-	mprotect(
-		align_pointer(si->si_addr, pagesize), pagesize,
-		PROT_READ | PROT_EXEC | PROT_WRITE);
-	regions_of_interest.push_back((uint8_t*)align_pointer(si->si_addr, pagesize));
-	return;
+	alignas(pagesize) static volatile uint8_t probe[pagesize];
+	probe[0] = 1;
+	if (!clearSoftDirty(clearRefsFd) || isSoftDirty(pagemapFd, const_cast<uint8_t*>(probe)))
+		return false;
+
+	probe[0] = 2;
+	return isSoftDirty(pagemapFd, const_cast<uint8_t*>(probe));
 }
 
+template <class F>
+static void forEachSetBit(const std::vector<uint64_t>& bitmap, F&& f)
+{
+	for (size_t w = 0; w < bitmap.size(); w++)
+	{
+		for (uint64_t bits = bitmap[w]; bits; bits &= bits - 1)
+			f(w * 64 + std::countr_zero(bits));
+	}
+}
+
+// Copies a page around the cache. Slot pages are rarely read back soon, so
+// this keeps the game's working set resident across saves.
+static void streamPage(uint8_t* dst, const uint8_t* src)
+{
+#if defined(__SSE2__)
+	for (size_t i = 0; i < pagesize; i += 4 * sizeof(__m128i))
+	{
+		__m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+		__m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i) + 1);
+		__m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i) + 2);
+		__m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i) + 3);
+		_mm_stream_si128(reinterpret_cast<__m128i*>(dst + i), a);
+		_mm_stream_si128(reinterpret_cast<__m128i*>(dst + i) + 1, b);
+		_mm_stream_si128(reinterpret_cast<__m128i*>(dst + i) + 2, c);
+		_mm_stream_si128(reinterpret_cast<__m128i*>(dst + i) + 3, d);
+	}
+#else
+	memcpy(dst, src, pagesize);
+#endif
+}
+
+static void streamFence()
+{
+#if defined(__SSE2__)
+	_mm_sfence();
 #endif
-LibSm64::LibSm64(const LibSm64Config& config) : config(config), dll(config.dllPath)
+}
+
+// Visits runs of set pages that are consecutive both in the bitmap and in memory
+template <class A, class F>
+static void forEachPageRun(const std::vector<uint64_t>& bitmap, A&& pageAddress, F&& f)
+{
+	size_t runStart = 0, runLength = 0;
+	uint8_t* runBegin = nullptr;
+	forEachSetBit(bitmap, [&](size_t pageIndex)
+	{
+		uint8_t* page = pageAddress(pageIndex);
+		if (runLength && pageIndex == runStart + runLength && page == runBegin + runLength * pagesize)
+		{
+			runLength++;
+			return;
+		}
+
+		if (runLength)
+			f(runStart, runBegin, runLength);
+		runStart = pageIndex;
+		runBegin = page;
+		runLength = 1;
+	});
+
+	if (runLength)
+		f(runStart, runBegin, runLength);
+}
+
+static size_t countPages(const std::vector<uint64_t>& bitmap)
+{
+	size_t nPages = 0;
+	for (uint64_t word : bitmap)
+		nPages += std::popcount(word);
+	return nPages;
+}
+
+static uint64_t mixWords(uint64_t a, uint64_t b)
+{
+	unsigned __int128 product = static_cast<unsigned __int128>(a) * b;
+	return static_cast<uint64_t>(product) ^ static_cast<uint64_t>(product >> 64);
+}
+
+// Two multiply-fold lanes over 16 bytes each, which keeps up with memcpy.
+// Equal hashes are still compared byte for byte before a page is shared.
+static LibSm64PageHash hashPage(const uint8_t* page)
+{
+	constexpr uint64_t k0 = 0xa0761d6478bd642full, k1 = 0xe7037ed1a0b428dbull;
+	constexpr uint64_t k2 = 0x8ebc6af09c88c6e3ull, k3 = 0x589965cc75374cc3ull;
+
+	uint64_t h0 = k0, h1 = k2;
+	for (size_t i = 0; i < pagesize; i += 4 * sizeof(uint64_t))
+	{
+		uint64_t w[4];
+		memcpy(w, page + i, sizeof(w));
+		h0 = mixWords(w[0] ^ h0 ^ k0, w[1] ^ k1);
+		h1 = mixWords(w[2] ^ h1 ^ k2, w[3] ^ k3);
+	}
+
+	return LibSm64PageHash {mixWords(h0 ^ k1, h1 ^ k0), mixWords(h0 ^ k3, h1 ^ k2)};
+}
+
+std::shared_ptr<const LibSm64AlignedPage> LibSm64PageStore::Store(const uint8_t* page)
+{
+	_stats.nStores++;
+	LibSm64PageHash hash = hashPage(page);
+
+	auto entry = _pages.find(hash);
+	if (entry != _pages.end())
+	{
+		std::shared_ptr<const LibSm64AlignedPage> stored = entry->second.lock();
+		if (stored && memcmp(stored->bytes, page, pagesize) == 0)
+		{
+			_stats.nDuplicates++;
+			return stored;
+		}
+	}
+
+	auto* copy = new LibSm64AlignedPage;
+	memcpy(copy->bytes, page, pagesize);
+
+	// Slots can outlive the store while the resource is destroyed
+	std::weak_ptr<LibSm64PageStore> owner = weak_from_this();
+	std::shared_ptr<const LibSm64AlignedPage> stored(copy, [owner, hash](const LibSm64AlignedPage* page)
+	{
+		if (std::shared_ptr<LibSm64PageStore> store = owner.lock())
+		{
+			// A colliding page that lost the table entry leaves it alone
+			auto entry = store->_pages.find(hash);
+			if (entry != store->_pages.end() && entry->second.expired())
+				store->_pages.erase(entry);
+			store->_stats.nPages--;
+		}
+
+		delete page;
+	});
+
+	if (entry == _pages.end())
+		_pages.emplace(hash, stored);
+	else if (entry->second.expired())
+		entry->second = stored;
+	_stats.nPages++;
+
+	return stored;
+}
+
+LibSm64SnapshotFile::LibSm64SnapshotFile(size_t size)
+{
+	fd = memfd_create("libsm64-snapshot", MFD_CLOEXEC);
+	if (fd == -1)
+		throw std::runtime_error("Failed to create a snapshot memfd.");
+	if (ftruncate(fd, static_cast<off_t>(size)) != 0)
+	{
+		close(fd);
+		throw std::runtime_error("Failed to size a snapshot memfd.");
+	}
+}
+
+LibSm64SnapshotFile::~LibSm64SnapshotFile()
+{
+	close(fd);
+}
+
+std::shared_ptr<const LibSm64SnapshotPool::Snapshot> LibSm64SnapshotPool::Acquire(size_t nPages)
+{
+	if (_freeSnapshots.empty())
+	{
+		// Sparse, so only the pages written take memory
+		size_t first = _files.size() * snapshotsPerFile;
+		_files.push_back(std::make_unique<LibSm64SnapshotFile>(snapshotsPerFile * _snapshotSize));
+		for (size_t i = snapshotsPerFile; i-- > 0;)
+			_freeSnapshots.push_back(first + i);
+	}
+
+	size_t index = _freeSnapshots.back();
+	_freeSnapshots.pop_back();
+	_nPages += nPages;
+	auto* snapshot = new Snapshot { _files[index / snapshotsPerFile]->fd, (index % snapshotsPerFile) * _snapshotSize };
+
+	// Slots can outlive the pool while the resource is destroyed
+	std::weak_ptr<LibSm64SnapshotPool> owner = weak_from_this();
+	return std::shared_ptr<const Snapshot>(snapshot, [owner, index, nPages](const Snapshot* snapshot)
+	{
+		if (std::shared_ptr<LibSm64SnapshotPool> pool = owner.lock())
+		{
+			fallocate(snapshot->fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, static_cast<off_t>(snapshot->offset), static_cast<off_t>(pool->_snapshotSize));
+			pool->_freeSnapshots.push_back(index);
+			pool->_nPages -= nPages;
+		}
+		delete snapshot;
+	});
+}
+
+#endif
+LibSm64::LibSm64(const LibSm64Config& config) : config(config), dll(config.dllPath, true)
 {
 	slotManager._saveMemLimit = 1024 * 1024 * 1024; //1 GB
+	slotManager.SetEvictionPolicy(std::make_unique<GreedyDualSizePolicy<LibSm64Mem>>());
+	slotManager.EnableCompressedTier(512 * 1024 * 1024); //512 MB
+	if (!config.saveSpillDirectory.empty())
+		slotManager.EnableDiskTier(config.saveSpillDirectory, config.saveSpillCapacity);
 
 	// constructor of SharedLib will throw if it can't load
 	void* processID = dll.get("sm64_init");
+	_sm64Update = reinterpret_cast<void(TAS_FW_STDCALL*)()>(dll.get("sm64_update"));
 
 	// Macro evalutes to nothing on Linux and __stdcall on Windows
 	// looks cleaner
@@ -48,33 +309,113 @@ LibSm64::LibSm64(const LibSm64Config& config) : config(config), dll(config.dllPa
 		SegVal {".data", sections[".data"].address, sections[".data"].length},
 		SegVal {".bss", sections[".bss"].address, sections[".bss"].length},
 	};
+
+	for (const auto& [name, section] : sections)
+	{
+		uint8_t* begin = static_cast<uint8_t*>(section.address);
+		if (!imageBegin || begin < imageBegin)
+			imageBegin = begin;
+		if (begin + section.length > imageEnd)
+			imageEnd = begin + section.length;
+	}
 #if !defined(_WIN32)
+	for (const SegVal& seg : segment)
+	{
+		TrackedRange range;
+		range.begin = static_cast<uint8_t*>(align_pointer(seg.address, pagesize));
+		range.end = static_cast<uint8_t*>(align_pointer(static_cast<uint8_t*>(seg.address) + seg.length + pagesize - 1, pagesize));
+		range.original.assign(range.begin, range.end);
+		trackedRanges.push_back(std::move(range));
+	}
 
-	original_buf1.resize(segment[0].length);
-	original_buf2.resize(segment[1].length);
+	// Page indices ascend with address, so walking a bitmap visits memory in order
+	std::sort(trackedRanges.begin(), trackedRanges.end(), [](const TrackedRange& a, const TrackedRange& b) { return a.begin < b.begin; });
+	size_t nTrackedPages = 0;
+	for (TrackedRange& range : trackedRanges)
+	{
+		range.firstPage = nTrackedPages;
+		nTrackedPages += (range.end - range.begin) / pagesize;
+	}
+	_roiBitmap.assign((nTrackedPages + 63) / 64, 0);
+	// A page is listed at most once per range between resets
+	regions_of_interest.reserve(nTrackedPages);
 
-	int64_t* temp = reinterpret_cast<int64_t*>(segment[0].address);
-	memcpy(original_buf1.data(), temp, segment[0].length);
+	if (config.savestates == LibSm64Savestates::MEMFD_REMAP)
+	{
+		if (config.incrementalSaves)
+			throw std::runtime_error("Memfd savestates don't support incremental saves.");
+		RemapTrackedRanges();
+	}
+	else if (config.savestates == LibSm64Savestates::PAGE_DEDUP)
+	{
+		if (config.incrementalSaves)
+			throw std::runtime_error("Deduplicated savestates don't support incremental saves.");
+		_pageStore = std::make_shared<LibSm64PageStore>();
+	}
 
-	temp = reinterpret_cast<int64_t*>(segment[1].address);
-	memcpy(original_buf2.data(), temp, segment[1].length);
+	// A learned profile fixes which pages are saved, so nothing needs tracking
+	if (_usesRegionProfile && ReadRegionProfile())
+	{
+		_profileActive = true;
+		_profileVersion++;
+	}
+	else if (config.tracking == LibSm64Tracking::SOFT_DIRTY)
+	{
+		_clearRefsFd = open("/proc/self/clear_refs", O_WRONLY);
+		_pagemapFd = open("/proc/self/pagemap", O_RDONLY);
+		if (_clearRefsFd == -1 || _pagemapFd == -1 || !softDirtyWorks(_clearRefsFd, _pagemapFd))
+			throw std::runtime_error("Soft-dirty page tracking is not supported on this system.");
+		if (softDirtyInUse.exchange(true))
+			throw std::runtime_error("Soft-dirty page tracking supports only one LibSm64 per process.");
+		_ownsSoftDirty = true;
+
+		ResetDirtyTracking();
+	}
+	else
+	{
+		std::call_once(segvHandlerInstalled, []()
+			{
+				struct sigaction sa;
+
+				sa.sa_flags = SA_SIGINFO;
+				sigemptyset(&sa.sa_mask);
+				sa.sa_sigaction = handler;
+				sigaction(SIGSEGV, &sa, &previousSegvAction);
+			});
+
+		bool registered = false;
+		for (std::atomic<LibSm64*>& entry : trackedInstances)
+		{
+			LibSm64* empty = nullptr;
+			if (entry.compare_exchange_strong(empty, this, std::memory_order_release))
+			{
+				registered = true;
+				break;
+			}
+		}
+		if (!registered)
+			throw std::runtime_error("Too many LibSm64 instances with write-fault tracking.");
+
+		ProtectTrackedRanges(PROT_READ | PROT_EXEC);
+	}
+#endif
 
-	struct sigaction sa;
+	ResolveSymbols();
 
-	sa.sa_flags = SA_SIGINFO;
-	sigemptyset(&sa.sa_mask);
-	sa.sa_sigaction = handler;
-	sigaction(SIGSEGV, &sa, NULL);
+	if (!config.saveCacheDirectory.empty())
+		EnablePersistentCache(config.saveCacheDirectory);
+}
 
-	mprotect(
-		align_pointer(sections[".data"].address, pagesize),
-		(sections[".data"].length & (~(pagesize - 1))) + pagesize,
-		PROT_READ | PROT_EXEC);
+LibSm64::~LibSm64()
+{
+#if !defined(_WIN32)
+	// Unloading the DLL writes to its sections, which no handler would catch anymore
+	StopTracking();
 
-	mprotect(
-		align_pointer(sections[".bss"].address, pagesize),
-		(sections[".bss"].length & (~(pagesize - 1))) + pagesize,
-		PROT_READ | PROT_EXEC);
+	if (_clearRefsFd != -1)
+		close(_clearRefsFd);
+	if (_pagemapFd != -1)
+		close(_pagemapFd);
 #endif
 }
 
@@ -107,12 +448,57 @@ void LibSm64::save(LibSm64Mem& state) const
 	temp = reinterpret_cast<int64_t*>(segment[1].address);
 	memcpy(state.buf2.data(), temp, segment[1].length);
 #else
-	state.changed_regions.reserve(regions_of_interest.size());
+	CollectDirtyPages();
+
+	if (config.incrementalSaves)
+	{
+		SaveIncremental(state);
+		return;
+	}
+	if (config.savestates == LibSm64Savestates::MEMFD_REMAP)
+	{
+		SaveMemfd(state);
+		return;
+	}
+
+	if (_profileActive && config.profileCheckInterval > 0 && ++_nSavesSinceCheck >= config.profileCheckInterval)
+	{
+		_nSavesSinceCheck = 0;
+		CheckRegionProfile();
+	}
+
+	UpdateRoiBitmap();
 	state.region_count_at_save_time = regions_of_interest.size();
-	for (const auto region : regions_of_interest) {
-		auto* data = state.changed_regions[region].data();
-		memcpy(data, region, pagesize);
+	state.pageBitmap.assign(_roiBitmap.begin(), _roiBitmap.end());
+
+	if (config.savestates == LibSm64Savestates::PAGE_DEDUP)
+	{
+		// releaseState() already dropped the record's previous references,
+		// only the vector's capacity is reused
+		state.pageRefs.resize(_nRoiPages);
+		size_t n = 0;
+		forEachSetBit(state.pageBitmap, [&](size_t pageIndex)
+		{
+			state.pageRefs[n++] = _pageStore->Store(GetPageAddress(pageIndex));
+		});
+		return;
 	}
+
+	state.payload.resize(_nRoiPages);
+
+	LibSm64AlignedPage* dst = state.payload.data();
+	forEachSetBit(state.pageBitmap, [&](size_t pageIndex)
+	{
+		const uint8_t* src = GetPageAddress(pageIndex);
+		if (config.nonTemporalSaves)
+			streamPage(dst->bytes, src);
+		else
+			memcpy(dst->bytes, src, pagesize);
+		dst++;
+	});
+
+	if (config.nonTemporalSaves)
+		streamFence();
 #endif
 }
 
@@ -136,26 +522,481 @@ void LibSm64::load(const LibSm64Mem& state)
 	memcpy(segment[0].address, state.buf1.data(), segment[0].length);
 	memcpy(segment[1].address, state.buf2.data(), segment[1].length);
 #else
-	if (regions_of_interest.size() != state.region_count_at_save_time) {
-		memcpy(segment[0].address, original_buf1.data(), segment[0].length);
-		memcpy(segment[1].address, original_buf2.data(), segment[1].length);
+	CollectDirtyPages();
+
+	if (config.incrementalSaves)
+	{
+		LoadIncremental(state);
+		return;
+	}
+	if (config.savestates == LibSm64Savestates::MEMFD_REMAP)
+	{
+		LoadMemfd(state);
+		return;
 	}
-	for (const auto& pair : state.changed_regions) {
-		memcpy(pair.first, pair.second.data(), pagesize);
+
+	// Pages first written after the slot was taken were still in their
+	// original state then. Every other page is either in the slot or has never
+	// been written.
+	if (regions_of_interest.size() != state.region_count_at_save_time)
+	{
+		UpdateRoiBitmap();
+		for (size_t w = 0; w < _roiBitmap.size(); w++)
+		{
+			uint64_t bits = _roiBitmap[w] & ~(w < state.pageBitmap.size() ? state.pageBitmap[w] : 0);
+			for (; bits; bits &= bits - 1)
+			{
+				uint8_t* page = GetPageAddress(w * 64 + std::countr_zero(bits));
+				memcpy(page, GetOriginalPage(page), pagesize);
+			}
+		}
+	}
+
+	if (config.savestates == LibSm64Savestates::PAGE_DEDUP)
+	{
+		auto src = state.pageRefs.begin();
+		forEachSetBit(state.pageBitmap, [&](size_t pageIndex)
+		{
+			memcpy(GetPageAddress(pageIndex), (*src)->bytes, pagesize);
+			src++;
+		});
+		return;
 	}
+
+	const LibSm64AlignedPage* src = state.payload.data();
+	forEachSetBit(state.pageBitmap, [&](size_t pageIndex)
+	{
+		memcpy(GetPageAddress(pageIndex), src->bytes, pagesize);
+		src++;
+	});
 #endif
 }
 
+#if !defined(_WIN32)
+void LibSm64::ProtectTrackedRanges(int protection) const
+{
+	for (const TrackedRange& range : trackedRanges)
+		mprotect(range.begin, range.end - range.begin, protection);
+}
+
+// Soft-dirty tracking only: move pages written since the last reset into
+// regions_of_interest. The fault handler does this eagerly otherwise.
+void LibSm64::CollectDirtyPages() const
+{
+	if (config.tracking != LibSm64Tracking::SOFT_DIRTY || _profileActive)
+		return;
+
+	for (const TrackedRange& range : trackedRanges)
+	{
+		size_t nPages = (range.end - range.begin) / pagesize;
+		_pagemapBuffer.resize(nPages);
+
+		off_t offset = (reinterpret_cast<uintptr_t>(range.begin) / pagesize) * sizeof(uint64_t);
+		ssize_t size = static_cast<ssize_t>(nPages * sizeof(uint64_t));
+		if (pread(_pagemapFd, _pagemapBuffer.data(), size, offset) != size)
+			throw std::runtime_error("Failed to read /proc/self/pagemap.");
+
+		for (size_t i = 0; i < nPages; i++)
+		{
+			if (!(_pagemapBuffer[i] & PAGEMAP_SOFT_DIRTY))
+				continue;
+
+			// Incremental saves want every page written since the reset; classic
+			// saves want each page once, ever
+			if (!config.incrementalSaves && !MarkRoiPage(range.firstPage + i))
+				continue;
+
+			regions_of_interest.push_back(range.begin + i * pagesize);
+		}
+	}
+}
+
+// Starts a new dirty epoch. Clearing soft-dirty bits is process-wide.
+void LibSm64::ResetDirtyTracking() const
+{
+	if (config.tracking == LibSm64Tracking::SOFT_DIRTY)
+	{
+		if (!clearSoftDirty(_clearRefsFd))
+			throw std::runtime_error("Failed to clear soft-dirty bits.");
+	}
+	else
+		ProtectTrackedRanges(PROT_READ | PROT_EXEC);
+}
+
+size_t LibSm64::GetPageIndex(const uint8_t* page) const
+{
+	for (const TrackedRange& range : trackedRanges)
+	{
+		if (page >= range.begin && page < range.end)
+			return range.firstPage + (page - range.begin) / pagesize;
+	}
+
+	return SIZE_MAX;
+}
+
+uint8_t* LibSm64::GetPageAddress(size_t pageIndex) const
+{
+	for (const TrackedRange& range : trackedRanges)
+	{
+		size_t nPages = (range.end - range.begin) / pagesize;
+		if (pageIndex - range.firstPage < nPages)
+			return range.begin + (pageIndex - range.firstPage) * pagesize;
+	}
+
+	throw std::runtime_error("Page index is outside of the tracked sections.");
+}
+
+// Returns whether the page was new to the bitmap
+bool LibSm64::MarkRoiPage(size_t pageIndex) const
+{
+	uint64_t bit = 1ull << (pageIndex % 64);
+	uint64_t& word = _roiBitmap[pageIndex / 64];
+	if (word & bit)
+		return false;
+
+	word |= bit;
+	_nRoiPages++;
+	return true;
+}
+
+// Folds pages appended to regions_of_interest since the last call into the bitmap
+void LibSm64::UpdateRoiBitmap() const
+{
+	for (; _nRoiFolded < regions_of_interest.size(); _nRoiFolded++)
+	{
+		size_t pageIndex = GetPageIndex(regions_of_interest[_nRoiFolded]);
+		if (pageIndex != SIZE_MAX)
+			MarkRoiPage(pageIndex);
+	}
+}
+
+const uint8_t* LibSm64::GetOriginalPage(const uint8_t* page) const
+{
+	for (const TrackedRange& range : trackedRanges)
+	{
+		if (page >= range.begin && page < range.end)
+			return range.original.data() + (page - range.begin);
+	}
+
+	throw std::runtime_error("Page is outside of the tracked sections.");
+}
+
+// Slots can outlive the resource while it is destroyed, so the count is shared
+std::shared_ptr<const LibSm64Page> LibSm64::CopyIncrementalPage(const uint8_t* page) const
+{
+	std::shared_ptr<int64_t> nPages = _nIncrementalPages;
+	(*nPages)++;
+
+	auto* copy = new LibSm64Page(*reinterpret_cast<const LibSm64Page*>(page));
+	return std::shared_ptr<const LibSm64Page>(copy, [nPages](const LibSm64Page* copy)
+	{
+		(*nPages)--;
+		delete copy;
+	});
+}
+
+// Copies only the pages written since the previous save or load, then starts
+// a new dirty epoch.
+void LibSm64::SaveIncremental(LibSm64Mem& state) const
+{
+	std::vector<uint8_t*>& dirtyPages = regions_of_interest;
+	if (dirtyPages.empty())
+	{
+		state.pages = _currentPages;
+		return;
+	}
+
+	std::sort(dirtyPages.begin(), dirtyPages.end());
+	dirtyPages.erase(std::unique(dirtyPages.begin(), dirtyPages.end()), dirtyPages.end());
+
+	auto pages = std::make_shared<LibSm64PageTable>();
+	pages->reserve(_currentPages->size() + dirtyPages.size());
+
+	auto current = _currentPages->begin();
+	for (uint8_t* page : dirtyPages)
+	{
+		while (current != _currentPages->end() && current->first < page)
+			pages->push_back(*current++);
+		if (current != _currentPages->end() && current->first == page)
+			current++;
+
+		pages->emplace_back(page, CopyIncrementalPage(page));
+	}
+	pages->insert(pages->end(), current, _currentPages->end());
+
+	state.pages = pages;
+	_currentPages = std::move(pages);
+
+	ResetDirtyTracking();
+	dirtyPages.clear();
+}
+
+// Writes a page only if it was dirtied since the last save or load, or if the
+// target snapshot holds a different version of it than the current one.
+void LibSm64::LoadIncremental(const LibSm64Mem& state)
+{
+	std::vector<uint8_t*>& dirtyPages = regions_of_interest;
+	if (dirtyPages.empty() && state.pages == _currentPages)
+		return;
+
+	std::sort(dirtyPages.begin(), dirtyPages.end());
+	dirtyPages.erase(std::unique(dirtyPages.begin(), dirtyPages.end()), dirtyPages.end());
+
+	static const LibSm64PageTable noPages;
+	const LibSm64PageTable& target = state.pages ? *state.pages : noPages;
+	const LibSm64PageTable& current = *_currentPages;
+
+	if (config.tracking == LibSm64Tracking::WRITE_FAULT)
+		ProtectTrackedRanges(PROT_READ | PROT_EXEC | PROT_WRITE);
+
+	size_t i = 0, j = 0, k = 0;
+	while (i < current.size() || j < target.size() || k < dirtyPages.size())
+	{
+		uint8_t* page = reinterpret_cast<uint8_t*>(UINTPTR_MAX);
+		if (i < current.size())
+			page = (std::min)(page, current[i].first);
+		if (j < target.size())
+			page = (std::min)(page, target[j].first);
+		if (k < dirtyPages.size())
+			page = (std::min)(page, dirtyPages[k]);
+
+		const LibSm64Page* have = i < current.size() && current[i].first == page ? current[i++].second.get() : nullptr;
+		const LibSm64Page* want = j < target.size() && target[j].first == page ? target[j++].second.get() : nullptr;
+		bool dirty = k < dirtyPages.size() && dirtyPages[k] == page;
+		if (dirty)
+			k++;
+
+		if (dirty || have != want)
+			memcpy(page, want ? want->data() : GetOriginalPage(page), pagesize);
+	}
+
+	ResetDirtyTracking();
+	dirtyPages.clear();
+	_currentPages = state.pages ? state.pages : std::make_shared<LibSm64PageTable>();
+}
+
+void LibSm64::StopTracking()
+{
+	for (std::atomic<LibSm64*>& entry : trackedInstances)
+	{
+		LibSm64* self = this;
+		if (entry.compare_exchange_strong(self, nullptr))
+			ProtectTrackedRanges(PROT_READ | PROT_EXEC | PROT_WRITE);
+	}
+
+	if (_ownsSoftDirty)
+	{
+		softDirtyInUse = false;
+		_ownsSoftDirty = false;
+	}
+}
+
+std::filesystem::path LibSm64::GetRegionProfilePath() const
+{
+	uint64_t layout[] = {REGION_PROFILE_VERSION, uint64_t(pagesize), uint64_t(_roiBitmap.size())};
+	uint64_t key = PersistentSaveCache::HashBytes(layout, sizeof(layout), PersistentSaveCache::HashFile(config.dllPath));
+
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.profile", static_cast<unsigned long long>(key));
+	return config.regionProfileDirectory / name;
+}
+
+// Region profile layout: the page bitmap, one uint64 word per 64 tracked pages
+bool LibSm64::ReadRegionProfile()
+{
+	if (config.regionProfileDirectory.empty())
+		return false;
+
+	std::vector<uint64_t> profile(_roiBitmap.size());
+	std::ifstream stream(GetRegionProfilePath(), std::ios::binary);
+	if (!stream.read(reinterpret_cast<char*>(profile.data()), profile.size() * sizeof(uint64_t)) || stream.peek() != EOF)
+		return false;
+
+	forEachSetBit(profile, [&](size_t pageIndex)
+	{
+		if (MarkRoiPage(pageIndex))
+			regions_of_interest.push_back(GetPageAddress(pageIndex));
+	});
+	_nRoiFolded = regions_of_interest.size();
+	return true;
+}
+
+void LibSm64::WriteRegionProfile() const
+{
+	if (config.regionProfileDirectory.empty())
+		return;
+
+	std::error_code error;
+	std::filesystem::create_directories(config.regionProfileDirectory, error);
+
+	// Write under a unique name and rename, so that concurrent runs never
+	// observe a partial file
+	std::filesystem::path path = GetRegionProfilePath();
+	std::filesystem::path temporaryPath = path;
+	temporaryPath += "." + std::to_string(_sessionId) + ".tmp";
+	{
+		std::ofstream stream(temporaryPath, std::ios::binary | std::ios::trunc);
+		if (!stream.write(reinterpret_cast<const char*>(_roiBitmap.data()), _roiBitmap.size() * sizeof(uint64_t)))
+		{
+			stream.close();
+			std::filesystem::remove(temporaryPath, error);
+			return;
+		}
+	}
+
+	std::filesystem::rename(temporaryPath, path, error);
+	if (error)
+		std::filesystem::remove(temporaryPath, error);
+}
+
+// Ends the warm-up: the pages written so far become the profile
+void LibSm64::ActivateRegionProfile()
+{
+	CollectDirtyPages();
+	UpdateRoiBitmap();
+	StopTracking();
+	_profileActive = true;
+	_profileVersion++;
+	WriteRegionProfile();
+}
+
+// Adds pages that differ from their original contents but aren't in the
+// profile. States saved under the old profile don't hold what those pages
+// contained, so bumping the version makes the slot manager drop them.
+void LibSm64::CheckRegionProfile() const
+{
+	bool grew = false;
+	for (const TrackedRange& range : trackedRanges)
+	{
+		for (uint8_t* page = range.begin; page < range.end; page += pagesize)
+		{
+			size_t pageIndex = GetPageIndex(page);
+			if ((_roiBitmap[pageIndex / 64] >> (pageIndex % 64)) & 1)
+				continue;
+			if (memcmp(page, GetOriginalPage(page), pagesize) == 0)
+				continue;
+
+			MarkRoiPage(pageIndex);
+			regions_of_interest.push_back(page);
+			grew = true;
+		}
+	}
+
+	_nRoiFolded = regions_of_interest.size();
+	if (grew)
+	{
+		_profileVersion++;
+		WriteRegionProfile();
+	}
+}
+
+// Moves the tracked pages onto a copy of themselves in a memfd, mapped
+// privately, so that loads can map snapshot pages over them the same way.
+void LibSm64::RemapTrackedRanges()
+{
+	_originalFile = std::make_unique<LibSm64SnapshotFile>(_roiBitmap.size() * 64 * pagesize);
+	_snapshotPool = std::make_shared<LibSm64SnapshotPool>(_roiBitmap.size() * 64 * pagesize);
+	for (const TrackedRange& range : trackedRanges)
+	{
+		ssize_t size = range.end - range.begin;
+		off_t offset = static_cast<off_t>(range.firstPage * pagesize);
+		if (pwrite(_originalFile->fd, range.original.data(), size, offset) != size)
+			throw std::runtime_error("Failed to write the original sections to a memfd.");
+	}
+
+	for (const TrackedRange& range : trackedRanges)
+	{
+		off_t offset = static_cast<off_t>(range.firstPage * pagesize);
+		if (mmap(range.begin, range.end - range.begin, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_PRIVATE | MAP_FIXED, _originalFile->fd, offset) == MAP_FAILED)
+			throw std::runtime_error("Failed to map the sections onto a memfd.");
+	}
+}
+
+// Writes the pages written since init into the slot's snapshot file. The
+// kernel does the copy, and a run of adjacent pages takes one call.
+void LibSm64::SaveMemfd(LibSm64Mem& state) const
+{
+	UpdateRoiBitmap();
+	state.region_count_at_save_time = regions_of_interest.size();
+	state.pageBitmap.assign(_roiBitmap.begin(), _roiBitmap.end());
+	state.payload.clear();
+
+	// Always a fresh one: a snapshot mapped by the last load still backs pages
+	// the game hasn't written since
+	state.snapshot = _snapshotPool->Acquire(countPages(state.pageBitmap));
+
+	const LibSm64SnapshotPool::Snapshot& snapshot = *state.snapshot;
+	forEachPageRun(state.pageBitmap, [this](size_t pageIndex) { return GetPageAddress(pageIndex); },
+		[&snapshot](size_t firstPage, uint8_t* begin, size_t nPages)
+		{
+			ssize_t size = static_cast<ssize_t>(nPages * pagesize);
+			if (pwrite(snapshot.fd, begin, size, static_cast<off_t>(snapshot.offset + firstPage * pagesize)) != size)
+				throw std::runtime_error("Failed to write a snapshot memfd.");
+		});
+}
+
+// Maps the slot's pages copy-on-write, and the original pages over the ones
+// written since init that the slot doesn't hold. Pages are only copied once
+// the game writes them again.
+void LibSm64::LoadMemfd(const LibSm64Mem& state)
+{
+	UpdateRoiBitmap();
+
+	// Pages of a foreign state may never have been written here
+	_remapBitmap.assign(_roiBitmap.size(), 0);
+	for (size_t w = 0; w < _roiBitmap.size(); w++)
+	{
+		uint64_t target = w < state.pageBitmap.size() ? state.pageBitmap[w] : 0;
+		_nRoiPages += std::popcount(target & ~_roiBitmap[w]);
+		_roiBitmap[w] |= target;
+		_remapBitmap[w] = _roiBitmap[w] & ~target;
+	}
+
+	int protection = config.tracking == LibSm64Tracking::WRITE_FAULT ? PROT_READ | PROT_EXEC : PROT_READ | PROT_WRITE | PROT_EXEC;
+	auto pageAddress = [this](size_t pageIndex) { return GetPageAddress(pageIndex); };
+	auto mapRuns = [&](const std::vector<uint64_t>& bitmap, int fd, size_t offset)
+	{
+		forEachPageRun(bitmap, pageAddress, [&](size_t firstPage, uint8_t* begin, size_t nPages)
+		{
+			if (mmap(begin, nPages * pagesize, protection, MAP_PRIVATE | MAP_FIXED, fd, static_cast<off_t>(offset + firstPage * pagesize)) == MAP_FAILED)
+				throw std::runtime_error("Failed to map snapshot pages.");
+		});
+	};
+
+	mapRuns(_remapBitmap, _originalFile->fd, 0);
+	if (state.snapshot)
+		mapRuns(state.pageBitmap, state.snapshot->fd, state.snapshot->offset);
+	_mappedSnapshot = state.snapshot;
+
+	// Every remapped page is clean and trapped again, so it will be listed anew
+	regions_of_interest.clear();
+	_nRoiFolded = 0;
+	if (config.tracking == LibSm64Tracking::SOFT_DIRTY)
+		ResetDirtyTracking();
+}
+#endif
+
 void LibSm64::advance()
 {
-	void* processID = dll.get("sm64_update");
+	_sm64Update();
 
-	using pICFUNC = void(TAS_FW_STDCALL*)();
+#if !defined(_WIN32)
+	if (_usesRegionProfile && !_profileActive && ++_nWarmupFrames >= config.profileWarmupFrames)
+		ActivateRegionProfile();
+#endif
+}
 
-	pICFUNC sm64_update;
-	sm64_update = pICFUNC(processID);
+void LibSm64::advanceFrames(std::span<const Inputs> inputs)
+{
+	uint8_t* controllerPads = getSymbol<uint8_t>(GameSymbol::gControllerPads);
+	for (const Inputs& frameInputs : inputs)
+	{
+		memcpy(controllerPads, &frameInputs.buttons, sizeof(uint16_t));
+		controllerPads[2] = static_cast<uint8_t>(frameInputs.stick_x);
+		controllerPads[3] = static_cast<uint8_t>(frameInputs.stick_y);
 
-	sm64_update();
+		LibSm64::advance();
+	}
 }
 
 void* LibSm64::addr(const char* symbol) const
@@ -168,11 +1009,255 @@ std::size_t LibSm64::getStateSize(const LibSm64Mem& state) const
 #if defined(_WIN32)
 	return state.buf1.capacity() + state.buf2.capacity();
 #else
-	return state.changed_regions.size()*pagesize;
+	// The pages themselves are charged once, by getSharedStateSize(), for as
+	// long as any snapshot refers to them
+	if (config.incrementalSaves)
+		return state.pages ? state.pages->size() * sizeof(LibSm64PageTable::value_type) : 0;
+	// The pages themselves live in the snapshot pool or the page store, and
+	// are charged once by getSharedStateSize()
+	if (config.savestates == LibSm64Savestates::MEMFD_REMAP || config.savestates == LibSm64Savestates::PAGE_DEDUP)
+		return state.pageRefs.capacity() * sizeof(state.pageRefs[0]) + state.pageBitmap.capacity() * sizeof(uint64_t);
+
+	return state.payload.capacity() * pagesize + state.pageBitmap.capacity() * sizeof(uint64_t);
+#endif
+}
+
+std::size_t LibSm64::getSharedStateSize() const
+{
+#if defined(_WIN32)
+	return 0;
+#else
+	return (_pageStore ? _pageStore->GetSize() : 0) + (_snapshotPool ? _snapshotPool->GetSize() : 0) +
+		size_t(*_nIncrementalPages) * pagesize;
 #endif
 }
 
-uint32_t LibSm64::getCurrentFrame() const
+void LibSm64::releaseState(LibSm64Mem& state) const
 {
-	return *(uint32_t*)(addr("gGlobalTimer")) - 1;
-}
\ No newline at end of file
+#if !defined(_WIN32)
+	state.pageRefs.clear();
+	state.snapshot.reset();
+#endif
+}
+
+// States saved during the warm-up, or without a profile, tracked every write
+// and stay exact. Profile states are only exact while the profile is unchanged.
+uint64_t LibSm64::getStateEpoch() const
+{
+#if defined(_WIN32)
+	return 0;
+#else
+	return _profileActive ? _profileVersion : 0;
+#endif
+}
+
+// Serialized layout: a header of uint64 words padded to a page boundary,
+// followed by page-aligned payload so that the compressed tier can share
+// identical pages between slots. Page addresses are stored relative to .data,
+// and the image span is recorded. States hold absolute pointers into the
+// image that can't be told apart from other data, so a state saved with the
+// DLL mapped elsewhere is refused rather than patched. Persisted states are
+// therefore only reused across runs when the load address repeats, e.g. with
+// ASLR disabled; otherwise they are rebuilt.
+static constexpr uint64_t SERIALIZE_VERSION = 1;
+static constexpr size_t HEADER_WORDS = 5;
+
+static size_t pageAlign(size_t size)
+{
+	return (size + pagesize - 1) & ~size_t(pagesize - 1);
+}
+
+bool LibSm64::serialize(const LibSm64Mem& state, std::vector<uint8_t>& out) const
+{
+#if defined(_WIN32)
+	size_t nPayloadBytes = state.buf1.size() + state.buf2.size();
+	size_t payloadOffset = pageAlign(HEADER_WORDS * sizeof(uint64_t));
+	out.assign(payloadOffset + nPayloadBytes, 0);
+
+	uint64_t* header = reinterpret_cast<uint64_t*>(out.data());
+	header[2] = state.buf1.size();
+	header[3] = state.buf2.size();
+	memcpy(out.data() + payloadOffset, state.buf1.data(), state.buf1.size());
+	memcpy(out.data() + payloadOffset + state.buf1.size(), state.buf2.data(), state.buf2.size());
+#else
+	size_t nPages = config.incrementalSaves ? (state.pages ? state.pages->size() : 0) : state.payload.size();
+	if (config.savestates == LibSm64Savestates::MEMFD_REMAP)
+		nPages = countPages(state.pageBitmap);
+	else if (config.savestates == LibSm64Savestates::PAGE_DEDUP)
+		nPages = state.pageRefs.size();
+	size_t payloadOffset = pageAlign((HEADER_WORDS + nPages) * sizeof(uint64_t));
+	out.assign(payloadOffset + nPages * pagesize, 0);
+
+	uint64_t* header = reinterpret_cast<uint64_t*>(out.data());
+	header[2] = _sessionId;
+	header[3] = state.region_count_at_save_time;
+	header[4] = nPages;
+
+	uint8_t* base = reinterpret_cast<uint8_t*>(segment[0].address);
+	size_t i = 0;
+	auto writePage = [&](const void* region, const uint8_t* page)
+	{
+		header[HEADER_WORDS + i] = static_cast<uint64_t>(static_cast<const uint8_t*>(region) - base);
+		memcpy(out.data() + payloadOffset + i * pagesize, page, pagesize);
+		i++;
+	};
+
+	if (config.incrementalSaves)
+	{
+		for (size_t n = 0; n < nPages; n++)
+			writePage((*state.pages)[n].first, (*state.pages)[n].second->data());
+	}
+	else if (config.savestates == LibSm64Savestates::MEMFD_REMAP)
+	{
+		LibSm64Page page;
+		forEachSetBit(state.pageBitmap, [&](size_t pageIndex)
+		{
+			if (!state.snapshot || pread(state.snapshot->fd, page.data(), pagesize, static_cast<off_t>(state.snapshot->offset + pageIndex * pagesize)) != pagesize)
+				throw std::runtime_error("Failed to read a snapshot memfd.");
+			writePage(GetPageAddress(pageIndex), page.data());
+		});
+	}
+	else if (config.savestates == LibSm64Savestates::PAGE_DEDUP)
+	{
+		auto page = state.pageRefs.begin();
+		forEachSetBit(state.pageBitmap, [&](size_t pageIndex)
+		{
+			writePage(GetPageAddress(pageIndex), (*page)->bytes);
+			page++;
+		});
+	}
+	else
+	{
+		const LibSm64AlignedPage* page = state.payload.data();
+		forEachSetBit(state.pageBitmap, [&](size_t pageIndex)
+		{
+			writePage(GetPageAddress(pageIndex), page->bytes);
+			page++;
+		});
+	}
+#endif
+
+	header[0] = reinterpret_cast<uint64_t>(imageBegin);
+	header[1] = reinterpret_cast<uint64_t>(imageEnd);
+	return true;
+}
+
+bool LibSm64::deserialize(std::span<const uint8_t> in, LibSm64Mem& state) const
+{
+	uint64_t header[HEADER_WORDS];
+	if (in.size() < sizeof(header))
+		return false;
+	memcpy(header, in.data(), sizeof(header));
+
+	if (header[0] != reinterpret_cast<uint64_t>(imageBegin) || header[1] != reinterpret_cast<uint64_t>(imageEnd))
+		return false;
+
+#if defined(_WIN32)
+	size_t payloadOffset = pageAlign(sizeof(header));
+	if (in.size() != payloadOffset + header[2] + header[3])
+		return false;
+
+	state.buf1.assign(in.begin() + payloadOffset, in.begin() + payloadOffset + header[2]);
+	state.buf2.assign(in.begin() + payloadOffset + header[2], in.end());
+#else
+	uint64_t nRegions = header[4];
+	size_t payloadOffset = pageAlign((HEADER_WORDS + nRegions) * sizeof(uint64_t));
+	if (in.size() != payloadOffset + nRegions * pagesize)
+		return false;
+
+	// A foreign state forces load() to reset to the original sections first.
+	// Its pages are written through the write trap, so they become tracked.
+	state.region_count_at_save_time = header[2] == _sessionId ? header[3] : UINT64_MAX;
+
+	auto pages = std::make_shared<LibSm64PageTable>();
+	std::vector<std::pair<size_t, uint64_t>> pageOrder; // page index, position in the payload
+	if (config.incrementalSaves)
+		pages->reserve(nRegions);
+	else
+		pageOrder.reserve(nRegions);
+
+	uint8_t* base = reinterpret_cast<uint8_t*>(segment[0].address);
+	for (uint64_t i = 0; i < nRegions; i++)
+	{
+		uint64_t offset;
+		memcpy(&offset, in.data() + (HEADER_WORDS + i) * sizeof(uint64_t), sizeof(uint64_t));
+
+		if (config.incrementalSaves)
+		{
+			pages->emplace_back(base + offset, CopyIncrementalPage(in.data() + payloadOffset + i * pagesize));
+			continue;
+		}
+
+		size_t pageIndex = GetPageIndex(base + offset);
+		if (pageIndex == SIZE_MAX)
+			return false;
+		pageOrder.emplace_back(pageIndex, i);
+	}
+
+	if (config.incrementalSaves)
+	{
+		std::sort(pages->begin(), pages->end());
+		state.pages = std::move(pages);
+		return true;
+	}
+
+	std::sort(pageOrder.begin(), pageOrder.end());
+	state.pageBitmap.assign(_roiBitmap.size(), 0);
+	if (config.savestates == LibSm64Savestates::MEMFD_REMAP)
+	{
+		state.payload.clear();
+		state.snapshot = _snapshotPool->Acquire(pageOrder.size());
+
+		LibSm64Page page;
+		for (auto [pageIndex, i] : pageOrder)
+		{
+			state.pageBitmap[pageIndex / 64] |= 1ull << (pageIndex % 64);
+
+			memcpy(page.data(), in.data() + payloadOffset + i * pagesize, pagesize);
+			if (pwrite(state.snapshot->fd, page.data(), pagesize, static_cast<off_t>(state.snapshot->offset + pageIndex * pagesize)) != pagesize)
+				return false;
+		}
+
+		return true;
+	}
+
+	if (config.savestates == LibSm64Savestates::PAGE_DEDUP)
+	{
+		state.payload.clear();
+		state.pageRefs.resize(nRegions);
+
+		LibSm64AlignedPage page;
+		for (size_t n = 0; n < pageOrder.size(); n++)
+		{
+			auto [pageIndex, i] = pageOrder[n];
+			state.pageBitmap[pageIndex / 64] |= 1ull << (pageIndex % 64);
+
+			memcpy(page.bytes, in.data() + payloadOffset + i * pagesize, pagesize);
+			state.pageRefs[n] = _pageStore->Store(page.bytes);
+		}
+
+		return true;
+	}
+
+	state.payload.resize(nRegions);
+	for (size_t n = 0; n < pageOrder.size(); n++)
+	{
+		auto [pageIndex, i] = pageOrder[n];
+		state.pageBitmap[pageIndex / 64] |= 1ull << (pageIndex % 64);
+
+		uint8_t* page = state.payload[n].bytes;
+		memcpy(page, in.data() + payloadOffset + i * pagesize, pagesize);
+	}
+#endif
+
+	return true;
+}
+
+uint64_t LibSm64::getPersistentKey() const
+{
+	// States hold raw pointers into the game's sections, so they only load
+	// back at the same address. Each load address gets its own directory.
+	uint64_t layout[] = {SERIALIZE_VERSION, uint64_t(config.countryCode), uint64_t(config.lightweight), uint64_t(pagesize),
+		reinterpret_cast<uint64_t>(imageBegin), reinterpret_cast<uint64_t>(imageEnd)};
+	return PersistentSaveCache::HashBytes(layout, sizeof(layout), PersistentSaveCache::HashFile(config.dllPath));
+}
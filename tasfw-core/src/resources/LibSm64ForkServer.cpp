@@ -0,0 +1,589 @@
+#include "tasfw/resources/LibSm64ForkServer.hpp"
+
+#if !defined(_WIN32)
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <ctime>
+#include <mutex>
+#include <semaphore.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+static constexpr size_t pagesize = 4096;
+static constexpr int32_t maxBatchFrames = 4096; // inputs of one ADVANCE_INPUTS command
+
+enum class ServerCommand : int32_t
+{
+	ADVANCE, // arg: number of frames
+	ADVANCE_INPUTS, // arg: number of frames, with their inputs in the input area
+	READ_PAGE, // arg: page index, copied to the exchange area
+	FORK // arg: entry the child process takes over
+};
+
+// Slot of a helper process in shared memory
+class ServerEntry
+{
+public:
+	sem_t wake;
+	ServerCommand command;
+	int32_t arg;
+	pid_t pid; // 0 while unused
+};
+
+class ServerControl
+{
+public:
+	sem_t done;
+	pid_t owner;
+	uint32_t nDirtyPages; // pages written by the owner, applied before the next command
+};
+
+// Waits for a post, giving up once the process that should post it is gone
+static bool waitFor(sem_t* sem, pid_t peer)
+{
+	for (;;)
+	{
+		timespec deadline;
+		clock_gettime(CLOCK_REALTIME, &deadline);
+		deadline.tv_sec += 1;
+		if (sem_timedwait(sem, &deadline) == 0)
+			return true;
+		if (errno != ETIMEDOUT)
+			continue;
+
+		// Helpers are reaped by their parent, or by the launcher once orphaned
+		if (waitpid(peer, nullptr, WNOHANG) == peer || (kill(peer, 0) == -1 && errno == ESRCH))
+			return false;
+	}
+}
+
+// Shared memory used by every process of one resource, and the bookkeeping of
+// its entries. Snapshots keep this alive so they can be released after the
+// resource itself.
+class ForkServerProcesses
+{
+public:
+	uint8_t* shared = nullptr;
+	size_t sharedSize = 0;
+	ServerControl* control = nullptr;
+	ServerEntry* entries = nullptr;
+	uint32_t* dirtyPages = nullptr;
+	Inputs* inputs = nullptr; // maxBatchFrames entries
+	uint8_t* exchange = nullptr; // one page per mirrored page
+	int32_t nEntries = 0;
+	int32_t launcherEntry = -1; // adopts orphaned helpers, so it is killed last
+	bool shutDown = false;
+
+	ForkServerProcesses(int32_t nEntries, size_t nPages);
+	~ForkServerProcesses();
+
+	int32_t AllocateEntry();
+	void Kill(int32_t entry);
+	void Shutdown();
+	bool Send(int32_t entry, ServerCommand command, int32_t arg);
+
+private:
+	std::vector<int32_t> _freeEntries;
+	std::vector<int32_t> _dyingEntries; // killed, but maybe not gone yet
+};
+
+class ForkSnapshot
+{
+public:
+	std::shared_ptr<ForkServerProcesses> processes;
+	int32_t entry;
+
+	ForkSnapshot(std::shared_ptr<ForkServerProcesses> processes, int32_t entry) : processes(std::move(processes)), entry(entry) { }
+	~ForkSnapshot() { processes->Kill(entry); }
+};
+
+ForkServerProcesses::ForkServerProcesses(int32_t nEntries, size_t nPages) : nEntries(nEntries)
+{
+	size_t entriesOffset = (sizeof(ServerControl) + alignof(ServerEntry) - 1) / alignof(ServerEntry) * alignof(ServerEntry);
+	size_t dirtyOffset = entriesOffset + nEntries * sizeof(ServerEntry);
+	size_t inputsOffset = (dirtyOffset + nPages * sizeof(uint32_t) + alignof(Inputs) - 1) / alignof(Inputs) * alignof(Inputs);
+	size_t exchangeOffset = (inputsOffset + maxBatchFrames * sizeof(Inputs) + pagesize - 1) / pagesize * pagesize;
+	sharedSize = exchangeOffset + nPages * pagesize;
+
+	void* mapping = mmap(nullptr, sharedSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (mapping == MAP_FAILED)
+		throw std::runtime_error("Failed to map fork server memory.");
+
+	shared = static_cast<uint8_t*>(mapping);
+	control = reinterpret_cast<ServerControl*>(shared);
+	entries = reinterpret_cast<ServerEntry*>(shared + entriesOffset);
+	dirtyPages = reinterpret_cast<uint32_t*>(shared + dirtyOffset);
+	inputs = reinterpret_cast<Inputs*>(shared + inputsOffset);
+	exchange = shared + exchangeOffset;
+
+	sem_init(&control->done, 1, 0);
+	control->owner = getpid();
+	for (int32_t i = nEntries - 1; i >= 0; i--)
+	{
+		sem_init(&entries[i].wake, 1, 0);
+		_freeEntries.push_back(i);
+	}
+}
+
+ForkServerProcesses::~ForkServerProcesses()
+{
+	Shutdown();
+	munmap(shared, sharedSize);
+}
+
+int32_t ForkServerProcesses::AllocateEntry()
+{
+	if (_freeEntries.empty())
+	{
+		for (size_t i = 0; i < _dyingEntries.size();)
+		{
+			ServerEntry& entry = entries[_dyingEntries[i]];
+			if (entry.pid > 0 && waitpid(entry.pid, nullptr, WNOHANG) != entry.pid && kill(entry.pid, 0) == 0)
+			{
+				i++;
+				continue;
+			}
+
+			// Nobody waits on the semaphore anymore, so it can be reset
+			entry.pid = 0;
+			sem_destroy(&entry.wake);
+			sem_init(&entry.wake, 1, 0);
+			_freeEntries.push_back(_dyingEntries[i]);
+			_dyingEntries[i] = _dyingEntries.back();
+			_dyingEntries.pop_back();
+		}
+	}
+
+	if (_freeEntries.empty())
+		throw std::runtime_error("Too many fork server processes.");
+
+	int32_t entry = _freeEntries.back();
+	_freeEntries.pop_back();
+	return entry;
+}
+
+void ForkServerProcesses::Kill(int32_t entry)
+{
+	if (shutDown)
+		return;
+
+	if (entries[entry].pid > 0)
+		kill(entries[entry].pid, SIGKILL);
+	_dyingEntries.push_back(entry);
+}
+
+void ForkServerProcesses::Shutdown()
+{
+	if (shutDown)
+		return;
+
+	for (int32_t i = 0; i < nEntries; i++)
+	{
+		if (i != launcherEntry && entries[i].pid > 0)
+			kill(entries[i].pid, SIGKILL);
+	}
+
+	// Helpers orphaned by the kills are reaped by the launcher, so it has to outlive them
+	for (int32_t i = 0; i < nEntries; i++)
+	{
+		pid_t pid = entries[i].pid;
+		while (i != launcherEntry && pid > 0 && kill(pid, 0) == 0)
+			usleep(100);
+	}
+
+	if (launcherEntry != -1 && entries[launcherEntry].pid > 0)
+	{
+		kill(entries[launcherEntry].pid, SIGKILL);
+		waitpid(entries[launcherEntry].pid, nullptr, 0);
+	}
+
+	shutDown = true;
+}
+
+bool ForkServerProcesses::Send(int32_t entry, ServerCommand command, int32_t arg)
+{
+	entries[entry].command = command;
+	entries[entry].arg = arg;
+	sem_post(&entries[entry].wake);
+	return waitFor(&control->done, entries[entry].pid);
+}
+
+// Instances with a mirror, so that a fault is routed to the instance owning
+// the page. Only constructors and destructors write to this.
+static constexpr size_t MAX_FORK_SERVERS = 64;
+static std::atomic<const LibSm64ForkServer*> forkServers[MAX_FORK_SERVERS];
+static struct sigaction previousSegvAction;
+static std::once_flag segvHandlerInstalled;
+
+static void handler(int sig, siginfo_t* si, void* context)
+{
+	int savedErrno = errno;
+	uint8_t* page = reinterpret_cast<uint8_t*>(reinterpret_cast<uintptr_t>(si->si_addr) & ~uintptr_t(pagesize - 1));
+	for (const std::atomic<const LibSm64ForkServer*>& entry : forkServers)
+	{
+		const LibSm64ForkServer* instance = entry.load(std::memory_order_acquire);
+		if (instance && instance->HandleFault(page))
+		{
+			errno = savedErrno;
+			return;
+		}
+	}
+
+	if (previousSegvAction.sa_flags & SA_SIGINFO)
+		previousSegvAction.sa_sigaction(sig, si, context);
+	else if (previousSegvAction.sa_handler != SIG_DFL && previousSegvAction.sa_handler != SIG_IGN)
+		previousSegvAction.sa_handler(sig);
+	else
+		signal(SIGSEGV, SIG_DFL); // the faulting instruction reruns and takes the default action
+}
+
+LibSm64ForkServer::LibSm64ForkServer(const LibSm64ForkServerConfig& config) : dll(config.dllPath, true), config(config)
+{
+	slotManager._saveMemLimit = int64_t(config.maxSnapshots) * config.snapshotCost;
+	slotManager.SetEvictionPolicy(std::make_unique<GreedyDualSizePolicy<LibSm64ForkMem>>());
+
+	using pICFUNC = int(TAS_FW_STDCALL*)();
+	pICFUNC sm64_init = pICFUNC(dll.get("sm64_init"));
+	_sm64Update = reinterpret_cast<void(TAS_FW_STDCALL*)()>(dll.get("sm64_update"));
+
+	sm64_init();
+
+	// .data and .bss, page-aligned, with a shared boundary page merged
+	auto sections = dll.readSections();
+	for (const char* name : {".data", ".bss"})
+	{
+		uintptr_t begin = reinterpret_cast<uintptr_t>(sections[name].address);
+		uintptr_t end = begin + sections[name].length;
+		_ranges.push_back(PageRange {
+			reinterpret_cast<uint8_t*>(begin & ~uintptr_t(pagesize - 1)),
+			reinterpret_cast<uint8_t*>((end + pagesize - 1) & ~uintptr_t(pagesize - 1)),
+			0});
+	}
+	std::sort(_ranges.begin(), _ranges.end(), [](const PageRange& a, const PageRange& b) { return a.begin < b.begin; });
+	for (size_t i = 1; i < _ranges.size();)
+	{
+		if (_ranges[i].begin <= _ranges[i - 1].end)
+		{
+			_ranges[i - 1].end = (std::max)(_ranges[i - 1].end, _ranges[i].end);
+			_ranges.erase(_ranges.begin() + i);
+		}
+		else
+			i++;
+	}
+	for (PageRange& range : _ranges)
+	{
+		range.firstPage = _nPages;
+		_nPages += (range.end - range.begin) / pagesize;
+	}
+	_pageStates.assign(_nPages, PageState::CLEAN);
+
+	// Helpers need the symbols as well
+	ResolveSymbols();
+	_controllerPads = getSymbol<uint8_t>(GameSymbol::gControllerPads);
+	for (GameSymbol symbol : {GameSymbol::gControllerPads, GameSymbol::gGlobalTimer})
+	{
+		size_t pageIndex = GetPageIndex(getSymbol<uint8_t>(symbol));
+		if (pageIndex != SIZE_MAX && std::find(_eagerPages.begin(), _eagerPages.end(), pageIndex) == _eagerPages.end())
+			_eagerPages.push_back(uint32_t(pageIndex));
+	}
+
+	// The running process, the root snapshot and one being replaced, on top of the slots
+	_processes = std::make_shared<ForkServerProcesses>(2 * config.maxSnapshots + 4, _nPages);
+
+	// The only fork of this process, which may have other threads. The root
+	// snapshot is the launcher: it never runs the game, only forks and serves
+	// page reads, so locks held by those threads don't matter to it. Every
+	// other helper descends from it.
+	_rootEntry = _processes->AllocateEntry();
+	_processes->launcherEntry = _rootEntry;
+	pid_t pid = fork();
+	if (pid == -1)
+		throw std::runtime_error("Failed to fork the first server process.");
+	if (pid == 0)
+	{
+		// Helpers get orphaned when their parent is killed, and are reaped here
+		prctl(PR_SET_CHILD_SUBREAPER, 1);
+		_processes->entries[_rootEntry].pid = getpid();
+		Serve(_rootEntry);
+	}
+	_processes->entries[_rootEntry].pid = pid;
+
+	_activeEntry = Fork(_rootEntry);
+
+	std::call_once(segvHandlerInstalled, []()
+		{
+			struct sigaction sa;
+
+			sa.sa_flags = SA_SIGINFO;
+			sigemptyset(&sa.sa_mask);
+			sa.sa_sigaction = handler;
+			sigaction(SIGSEGV, &sa, &previousSegvAction);
+		});
+
+	bool registered = false;
+	for (std::atomic<const LibSm64ForkServer*>& entry : forkServers)
+	{
+		const LibSm64ForkServer* empty = nullptr;
+		if (entry.compare_exchange_strong(empty, this, std::memory_order_release))
+		{
+			registered = true;
+			break;
+		}
+	}
+	if (!registered)
+		throw std::runtime_error("Too many LibSm64ForkServer instances.");
+
+	// The mirror matches the first process until the first command
+	for (const PageRange& range : _ranges)
+		mprotect(range.begin, range.end - range.begin, PROT_READ);
+}
+
+LibSm64ForkServer::~LibSm64ForkServer()
+{
+	for (std::atomic<const LibSm64ForkServer*>& entry : forkServers)
+	{
+		const LibSm64ForkServer* self = this;
+		entry.compare_exchange_strong(self, nullptr);
+	}
+
+	// Unloading the DLL writes to its sections
+	for (const PageRange& range : _ranges)
+		mprotect(range.begin, range.end - range.begin, PROT_READ | PROT_WRITE);
+
+	_processes->Shutdown();
+}
+
+size_t LibSm64ForkServer::GetPageIndex(const uint8_t* page) const
+{
+	for (const PageRange& range : _ranges)
+	{
+		if (page >= range.begin && page < range.end)
+			return range.firstPage + (page - range.begin) / pagesize;
+	}
+
+	return SIZE_MAX;
+}
+
+uint8_t* LibSm64ForkServer::GetPageAddress(size_t pageIndex) const
+{
+	for (const PageRange& range : _ranges)
+	{
+		if (pageIndex - range.firstPage < size_t(range.end - range.begin) / pagesize)
+			return range.begin + (pageIndex - range.firstPage) * pagesize;
+	}
+
+	return nullptr;
+}
+
+bool LibSm64ForkServer::HandleFault(uint8_t* page) const
+{
+	size_t pageIndex = GetPageIndex(page);
+	if (pageIndex == SIZE_MAX)
+		return false;
+
+	switch (_pageStates[pageIndex])
+	{
+	case PageState::INVALID:
+		if (!_processes->Send(_activeEntry, ServerCommand::READ_PAGE, int32_t(pageIndex)))
+			abort(); // can't report anything from here
+
+		mprotect(page, pagesize, PROT_READ | PROT_WRITE);
+		memcpy(page, _processes->exchange + pageIndex * pagesize, pagesize);
+		mprotect(page, pagesize, PROT_READ);
+		_pageStates[pageIndex] = PageState::CLEAN;
+		return true;
+
+	case PageState::CLEAN:
+		// A write to a fetched page. It faults again after a fetch for a write.
+		mprotect(page, pagesize, PROT_READ | PROT_WRITE);
+		_processes->dirtyPages[_processes->control->nDirtyPages++] = uint32_t(pageIndex);
+		_pageStates[pageIndex] = PageState::DIRTY;
+		return true;
+
+	default:
+		return false;
+	}
+}
+
+// Stages pages written here for the running process and tracks them again
+void LibSm64ForkServer::FlushDirtyPages() const
+{
+	ServerControl& control = *_processes->control;
+	for (uint32_t i = 0; i < control.nDirtyPages; i++)
+	{
+		uint32_t pageIndex = _processes->dirtyPages[i];
+		uint8_t* page = GetPageAddress(pageIndex);
+		memcpy(_processes->exchange + size_t(pageIndex) * pagesize, page, pagesize);
+		mprotect(page, pagesize, PROT_READ);
+		_pageStates[pageIndex] = PageState::CLEAN;
+	}
+}
+
+// Called after every state change. The eager pages come back with the command.
+void LibSm64ForkServer::InvalidateMirror() const
+{
+	for (const PageRange& range : _ranges)
+		mprotect(range.begin, range.end - range.begin, PROT_NONE);
+	std::fill(_pageStates.begin(), _pageStates.end(), PageState::INVALID);
+	_processes->control->nDirtyPages = 0;
+
+	for (uint32_t pageIndex : _eagerPages)
+	{
+		uint8_t* page = GetPageAddress(pageIndex);
+		mprotect(page, pagesize, PROT_READ | PROT_WRITE);
+		memcpy(page, _processes->exchange + size_t(pageIndex) * pagesize, pagesize);
+		mprotect(page, pagesize, PROT_READ);
+		_pageStates[pageIndex] = PageState::CLEAN;
+	}
+}
+
+// Server side of InvalidateMirror(), once the state the owner switches to is reached
+void LibSm64ForkServer::SendEagerPages() const
+{
+	for (uint32_t pageIndex : _eagerPages)
+		memcpy(_processes->exchange + size_t(pageIndex) * pagesize, GetPageAddress(pageIndex), pagesize);
+}
+
+// Asks the process in an entry to fork, and returns the child's entry
+int32_t LibSm64ForkServer::Fork(int32_t entry) const
+{
+	int32_t childEntry = _processes->AllocateEntry();
+	bool ok = _processes->Send(entry, ServerCommand::FORK, childEntry);
+	_processes->control->nDirtyPages = 0;
+
+	if (!ok || _processes->entries[childEntry].pid <= 0)
+	{
+		_processes->Kill(childEntry);
+		throw std::runtime_error("Fork server process failed to fork.");
+	}
+
+	return childEntry;
+}
+
+// Command loop of a helper process. Runs until the owner kills it or exits.
+void LibSm64ForkServer::Serve(int32_t entry) const
+{
+	// Snapshots are forked from each other, and nobody waits for them
+	signal(SIGCHLD, SIG_IGN);
+
+	ForkServerProcesses& processes = *_processes;
+	ServerControl& control = *processes.control;
+	for (;;)
+	{
+		ServerEntry& self = processes.entries[entry];
+		if (!waitFor(&self.wake, control.owner))
+			_exit(0);
+
+		if (self.command == ServerCommand::READ_PAGE)
+		{
+			memcpy(processes.exchange + size_t(self.arg) * pagesize, GetPageAddress(self.arg), pagesize);
+			sem_post(&control.done);
+			continue;
+		}
+
+		for (uint32_t i = 0; i < control.nDirtyPages; i++)
+		{
+			uint32_t pageIndex = processes.dirtyPages[i];
+			memcpy(GetPageAddress(pageIndex), processes.exchange + size_t(pageIndex) * pagesize, pagesize);
+		}
+
+		if (self.command == ServerCommand::ADVANCE)
+		{
+			for (int32_t i = 0; i < self.arg; i++)
+				_sm64Update();
+			SendEagerPages();
+			sem_post(&control.done);
+			continue;
+		}
+
+		if (self.command == ServerCommand::ADVANCE_INPUTS)
+		{
+			for (int32_t i = 0; i < self.arg; i++)
+			{
+				const Inputs& frameInputs = processes.inputs[i];
+				memcpy(_controllerPads, &frameInputs.buttons, sizeof(uint16_t));
+				_controllerPads[2] = static_cast<uint8_t>(frameInputs.stick_x);
+				_controllerPads[3] = static_cast<uint8_t>(frameInputs.stick_y);
+				_sm64Update();
+			}
+			SendEagerPages();
+			sem_post(&control.done);
+			continue;
+		}
+
+		// The child is identical, and a load switches to it
+		SendEagerPages();
+		int32_t childEntry = self.arg;
+		pid_t pid = fork();
+		if (pid == 0)
+		{
+			// The child posts, so the owner sees its pid
+			entry = childEntry;
+			processes.entries[entry].pid = getpid();
+			sem_post(&control.done);
+		}
+		else if (pid == -1)
+		{
+			processes.entries[childEntry].pid = -1;
+			sem_post(&control.done);
+		}
+	}
+}
+
+void LibSm64ForkServer::save(LibSm64ForkMem& state) const
+{
+	FlushDirtyPages();
+	state.snapshot = std::make_shared<const ForkSnapshot>(_processes, Fork(_activeEntry));
+}
+
+void LibSm64ForkServer::load(const LibSm64ForkMem& state)
+{
+	// Writes made here belong to the state being left
+	_processes->control->nDirtyPages = 0;
+
+	int32_t previousEntry = _activeEntry;
+	_activeEntry = Fork(state.snapshot ? state.snapshot->entry : _rootEntry);
+	_processes->Kill(previousEntry);
+
+	InvalidateMirror();
+}
+
+void LibSm64ForkServer::advance()
+{
+	FlushDirtyPages();
+	if (!_processes->Send(_activeEntry, ServerCommand::ADVANCE, 1))
+		throw std::runtime_error("Fork server process died.");
+
+	InvalidateMirror();
+}
+
+// One command per batch instead of one per frame, with the inputs written
+// into the helper's controller pads rather than faulted through the mirror
+void LibSm64ForkServer::advanceFrames(std::span<const Inputs> inputs)
+{
+	for (size_t first = 0; first < inputs.size(); first += maxBatchFrames)
+	{
+		std::span<const Inputs> batch = inputs.subspan(first, (std::min)(inputs.size() - first, size_t(maxBatchFrames)));
+		FlushDirtyPages();
+		std::copy(batch.begin(), batch.end(), _processes->inputs);
+		if (!_processes->Send(_activeEntry, ServerCommand::ADVANCE_INPUTS, int32_t(batch.size())))
+			throw std::runtime_error("Fork server process died.");
+
+		InvalidateMirror();
+	}
+}
+
+void* LibSm64ForkServer::addr(const char* symbol) const
+{
+	return dll.get(symbol);
+}
+
+std::size_t LibSm64ForkServer::getStateSize(const LibSm64ForkMem&) const
+{
+	return config.snapshotCost;
+}
+#endif
@@ -6,6 +6,7 @@
 #include <sm64/Sm64.hpp>
 #include <sm64/SurfaceTerrains.hpp>
 #include <sm64/Camera.hpp>
+#include <type_traits>
 
 PyramidUpdateMem::PyramidUpdateMem(const LibSm64& resource, Object* pyramidLibSm64)
 {
@@ -23,14 +24,14 @@ PyramidUpdateMem::PyramidUpdateMem(const LibSm64& resource, Object* pyramidLibSm
 	LoadSurfaces(pyramidLibSm64, pyramid);
 
 	//Initialize Mario object
-	Object* marioObjLibSm64 = *(Object**)(resource.addr("gMarioObject"));
+	Object* marioObjLibSm64 = *resource.getSymbol<Object*>(GameSymbol::gMarioObject);
 	marioObj.posX = marioObjLibSm64->oPosX;
 	marioObj.posY = marioObjLibSm64->oPosY;
 	marioObj.posZ = marioObjLibSm64->oPosZ;
 	marioObj.platformIsPyramid = marioObjLibSm64->platform == pyramidLibSm64;
 
 	//Initialize Mario state
-	MarioState* marioStateLibSm64 = (MarioState*)(resource.addr("gMarioStates"));
+	MarioState* marioStateLibSm64 = resource.getSymbol<MarioState>(GameSymbol::gMarioStates);
 	marioState.posX = marioStateLibSm64->pos[0];
 	marioState.posY = marioStateLibSm64->pos[1];
 	marioState.posZ = marioStateLibSm64->pos[2];
@@ -40,7 +41,7 @@ PyramidUpdateMem::PyramidUpdateMem(const LibSm64& resource, Object* pyramidLibSm
 	AddStaticGeometry();
 
 	//Copy camera yaw
-	Camera* sm64Camera = *(Camera**)(resource.addr("gCamera"));
+	Camera* sm64Camera = *resource.getSymbol<Camera*>(GameSymbol::gCamera);
 	camera.yaw = sm64Camera->yaw;
 }
 
@@ -415,6 +416,16 @@ short PyramidUpdateMem::GetFloorClass(Sm64Surface* floor, u32 action)
 PyramidUpdate::PyramidUpdate()
 {
     slotManager._saveMemLimit = 1024 * 1024 * 1024; //1 GB
+    slotManager.SetEvictionPolicy(std::make_unique<GreedyDualSizePolicy<PyramidUpdateMem>>());
+    BindSymbols();
+}
+
+PyramidUpdate::PyramidUpdate(PyramidUpdateConfig config) : _enableMarioMovement(config.EnableMarioMovement)
+{
+	BindSymbols();
+
+	if (!config.saveCacheDirectory.empty())
+		EnablePersistentCache(config.saveCacheDirectory);
 }
 
 void PyramidUpdate::save(PyramidUpdateMem& state) const
@@ -432,9 +443,112 @@ std::size_t PyramidUpdate::getStateSize(const PyramidUpdateMem& state) const
 	return 2 * sizeof(PyramidUpdateMem) + 3 * sizeof(PyramidUpdateMem::Sm64Surface) * (state.pyramid.surfaces[0].capacity() + state.marioObj.surfaces[0].capacity());
 }
 
-uint32_t PyramidUpdate::getCurrentFrame() const
+static constexpr uint64_t SERIALIZE_VERSION = 1;
+
+template <typename T>
+	requires std::is_trivially_copyable_v<T>
+static void writeValue(std::vector<uint8_t>& out, const T& value)
+{
+	const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+	out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+template <typename T>
+static void writeVector(std::vector<uint8_t>& out, const std::vector<T>& values)
+{
+	writeValue(out, uint64_t(values.size()));
+	const uint8_t* bytes = reinterpret_cast<const uint8_t*>(values.data());
+	out.insert(out.end(), bytes, bytes + values.size() * sizeof(T));
+}
+
+template <typename T>
+	requires std::is_trivially_copyable_v<T>
+static bool readValue(std::span<const uint8_t>& in, T& value)
+{
+	if (in.size() < sizeof(T))
+		return false;
+
+	memcpy(&value, in.data(), sizeof(T));
+	in = in.subspan(sizeof(T));
+	return true;
+}
+
+template <typename T>
+static bool readVector(std::span<const uint8_t>& in, std::vector<T>& values)
+{
+	uint64_t size;
+	if (!readValue(in, size) || in.size() / sizeof(T) < size)
+		return false;
+
+	values.resize(size);
+	memcpy(values.data(), in.data(), size * sizeof(T));
+	in = in.subspan(size * sizeof(T));
+	return true;
+}
+
+static void writeObject(std::vector<uint8_t>& out, const PyramidUpdateMem::Sm64Object& object)
+{
+	writeValue(out, object.posX);
+	writeValue(out, object.posY);
+	writeValue(out, object.posZ);
+	writeValue(out, object.tiltingPyramidNormalX);
+	writeValue(out, object.tiltingPyramidNormalY);
+	writeValue(out, object.tiltingPyramidNormalZ);
+	writeValue(out, object.tiltingPyramidMarioOnPlatform);
+	writeValue(out, object.platformIsPyramid);
+	writeValue(out, object.transform);
+	for (const auto& surfaces : object.surfaces)
+		writeVector(out, surfaces);
+}
+
+static bool readObject(std::span<const uint8_t>& in, PyramidUpdateMem::Sm64Object& object)
 {
-	return _state.frame;
+	bool valid = readValue(in, object.posX)
+		&& readValue(in, object.posY)
+		&& readValue(in, object.posZ)
+		&& readValue(in, object.tiltingPyramidNormalX)
+		&& readValue(in, object.tiltingPyramidNormalY)
+		&& readValue(in, object.tiltingPyramidNormalZ)
+		&& readValue(in, object.tiltingPyramidMarioOnPlatform)
+		&& readValue(in, object.platformIsPyramid)
+		&& readValue(in, object.transform);
+
+	for (auto& surfaces : object.surfaces)
+		valid = valid && readVector(in, surfaces);
+
+	return valid;
+}
+
+bool PyramidUpdate::serialize(const PyramidUpdateMem& state, std::vector<uint8_t>& out) const
+{
+	out.clear();
+	writeObject(out, state.marioObj);
+	writeObject(out, state.pyramid);
+	writeVector(out, state.staticFloors);
+	writeValue(out, state.marioState);
+	writeValue(out, state.camera);
+	writeValue(out, state.frame);
+	writeValue(out, state.inputs);
+
+	return true;
+}
+
+bool PyramidUpdate::deserialize(std::span<const uint8_t> in, PyramidUpdateMem& state) const
+{
+	return readObject(in, state.marioObj)
+		&& readObject(in, state.pyramid)
+		&& readVector(in, state.staticFloors)
+		&& readValue(in, state.marioState)
+		&& readValue(in, state.camera)
+		&& readValue(in, state.frame)
+		&& readValue(in, state.inputs)
+		&& in.empty();
+}
+
+uint64_t PyramidUpdate::getPersistentKey() const
+{
+	uint64_t layout[] = {SERIALIZE_VERSION, sizeof(PyramidUpdateMem::Sm64Surface), sizeof(PyramidUpdateMem::Sm64MarioState), uint64_t(_enableMarioMovement)};
+	return PersistentSaveCache::HashBytes(layout, sizeof(layout));
 }
 
 void PyramidUpdate::advance()
@@ -465,25 +579,31 @@ void PyramidUpdate::advance()
 	_state.frame++;
 }
 
-void* PyramidUpdate::addr(const char* symbol) const
+// The state lives inside the resource, so its fields never move
+void PyramidUpdate::BindSymbols()
 {
-	std::string symbolStr = std::string(symbol);
-
-	if (symbolStr == "gMarioStates")
-		return (void*)&_state.marioState;
-
-	if (symbolStr == "gMarioObject")
-		return (void*)&_state.marioObj;
-
-	if (symbolStr == "Pyramid")
-		return (void*)&_state.pyramid;
+	_symbols[size_t(GameSymbol::gMarioStates)] = &_state.marioState;
+	_symbols[size_t(GameSymbol::gMarioObject)] = &_state.marioObj;
+	_symbols[size_t(GameSymbol::Pyramid)] = &_state.pyramid;
+	_symbols[size_t(GameSymbol::gControllerPads)] = &_state.inputs;
+}
 
-	if (symbolStr == "gControllerPads")
-		return (void*)&_state.inputs;
+void PyramidUpdate::advanceFrames(std::span<const Inputs> inputs)
+{
+	for (const Inputs& frameInputs : inputs)
+	{
+		SetInputs(frameInputs);
+		PyramidUpdate::advance();
+	}
+}
 
-	throw std::runtime_error("Unable to resolve symbol \"" + symbolStr + "\"");
+void* PyramidUpdate::addr(const char* symbol) const
+{
+	GameSymbol gameSymbol = FindGameSymbol(symbol);
+	if (gameSymbol == GameSymbol::COUNT || !_symbols[size_t(gameSymbol)])
+		throw std::runtime_error("Unable to resolve symbol \"" + std::string(symbol) + "\"");
 
-	return nullptr;
+	return _symbols[size_t(gameSymbol)];
 }
 
 void PyramidUpdate::UpdatePyramid()
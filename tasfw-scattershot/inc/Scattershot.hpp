@@ -90,6 +90,7 @@ public:
     int StartFromRootEveryNShots;
     std::filesystem::path M64Path;
     std::vector<std::filesystem::path> ResourcePaths;
+    int64_t SaveMemoryBudget = 0; // bytes shared by all threads' savestates, 0 to size from available memory
 
     template <class TContainer, typename TElement = typename TContainer::value_type>
         requires std::is_same_v<TElement, std::string>
@@ -113,13 +114,15 @@ public:
         scattershot.MultiThread(configuration.TotalThreads, [&]()
             {
                 int threadId = omp_get_thread_num();
-                if (threadId < configuration.ResourcePaths.size())
+                if (!configuration.ResourcePaths.empty())
                 {
                     M64 m64 = M64(configuration.M64Path);
                     m64.load();
 
+                    // Resources load isolated instances, so threads can share a path
+                    auto& resourcePath = configuration.ResourcePaths[threadId % configuration.ResourcePaths.size()];
                     auto status = TScattershotThread::template MainConfig<TScattershotThread>
-                        (m64, resourceConfigGenerator(configuration.ResourcePaths[threadId]), scattershot, threadId);
+                        (m64, resourceConfigGenerator(resourcePath), scattershot, threadId);
                 }
             });
     }
@@ -132,12 +135,12 @@ public:
         scattershot.MultiThread(configuration.TotalThreads, [&]()
             {
                 int threadId = omp_get_thread_num();
-                if (threadId < configuration.ResourcePaths.size())
+                if (!configuration.ResourcePaths.empty())
                 {
                     M64 m64 = M64(configuration.M64Path);
                     m64.load();
 
-                    auto resourcePath = configuration.ResourcePaths[threadId];
+                    auto resourcePath = configuration.ResourcePaths[threadId % configuration.ResourcePaths.size()];
                     auto status = TScattershotThread<TState, TResource>::template MainConfig<TScattershotThread<TState, TResource>>(m64, resourcePath, scattershot, threadId);
                 }
             });
@@ -108,6 +108,20 @@ Scattershot<TState, TResource>::Scattershot(const Configuration& config) : confi
     // Init shared hash table.
     for (int hashInx = 0; hashInx < config.MaxSharedHashes; hashInx++)
         SharedHashTable[hashInx] = -1;
+
+    // Savestates get half of what the block and hash arrays will leave free.
+    // Each thread's share covers its RAM and compressed slot tiers.
+    int64_t saveMemoryBudget = config.SaveMemoryBudget;
+    if (saveMemoryBudget == 0)
+    {
+        int64_t arrayMem = int64_t(config.TotalThreads * config.MaxBlocks + config.MaxSharedBlocks) * sizeof(Block<TState>)
+            + int64_t(config.TotalThreads * config.MaxHashes + config.MaxSharedHashes) * sizeof(int)
+            + int64_t(config.MaxSharedSegments + config.TotalThreads * config.MaxLocalSegments) * sizeof(Segment*);
+        saveMemoryBudget = (std::max)((SaveMemoryGovernor::GetAvailableMemory() - arrayMem) / 2,
+            int64_t(config.TotalThreads) * SaveMemoryGovernor::Global().minShare);
+    }
+
+    SaveMemoryGovernor::Global().SetBudget(saveMemoryBudget);
 }
 
 template <class TState, derived_from_specialization_of<Resource> TResource>
@@ -22,12 +22,13 @@ bool ScattershotThread<TState, TResource>::validation() { return true; }
 template <class TState, derived_from_specialization_of<Resource> TResource>
 bool ScattershotThread<TState, TResource>::execution()
 {
+    this->resource->slotManager.SetMemoryGovernor(SaveMemoryGovernor::Global());
     LongLoad(config.StartFrame);
     InitializeMemory();
 
     // Record start course/area for validation (generally scattershot has no cross-level value)
-    startCourse = *(short*)this->resource->addr("gCurrCourseNum");
-    startArea = *(short*)this->resource->addr("gCurrAreaIndex");
+    startCourse = *this->resource->template getSymbol<short>(GameSymbol::gCurrCourseNum);
+    startArea = *this->resource->template getSymbol<short>(GameSymbol::gCurrAreaIndex);
 
     for (int shot = 0; shot <= config.MaxShots; shot++)
     {
@@ -216,8 +217,8 @@ void ScattershotThread<TState, TResource>::SingleThread(F func)
 template <class TState, derived_from_specialization_of<Resource> TResource>
 bool ScattershotThread<TState, TResource>::ValidateCourseAndArea()
 {
-    return startCourse == *(short*)this->resource->addr("gCurrCourseNum")
-        && startArea == *(short*)this->resource->addr("gCurrAreaIndex");
+    return startCourse == *this->resource->template getSymbol<short>(GameSymbol::gCurrCourseNum)
+        && startArea == *this->resource->template getSymbol<short>(GameSymbol::gCurrAreaIndex);
 }
 
 template <class TState, derived_from_specialization_of<Resource> TResource>
@@ -233,7 +234,7 @@ bool ScattershotThread<TState, TResource>::ChooseScriptAndApply()
 
     // Execute script and update rng hash
     auto status = ModifyAdhoc([&]() { return ApplyMovement(); });
-    return status.executed && !status.m64Diff.frames.empty();
+    return status.executed && !status.m64Diff.frames.Empty();
 }
 
 template <class TState, derived_from_specialization_of<Resource> TResource>
@@ -418,8 +419,8 @@ Inputs ScattershotThread<TState, TResource>::RandomInputs(std::map<Buttons, doub
 
     ExecuteAdhoc([&]()
         {
-            MarioState* marioState = *(MarioState**)(this->resource->addr("gMarioState"));
-            Camera* camera = *(Camera**)(this->resource->addr("gCamera"));
+            MarioState* marioState = *this->resource->template getSymbol<MarioState*>(GameSymbol::gMarioState);
+            Camera* camera = *this->resource->template getSymbol<Camera*>(GameSymbol::gCamera);
 
             // stick mag
             float intendedMag = 0;
@@ -13,7 +13,7 @@
 bool BitFsPyramidOscillation::validation()
 {
 	// Check if Mario is on the pyramid platform
-	MarioState* marioState = (MarioState*) (resource->addr("gMarioStates"));
+	MarioState* marioState = resource->getSymbol<MarioState>(GameSymbol::gMarioStates);
 
 	Surface* floor = marioState->floor;
 	if (!floor)
@@ -23,7 +23,7 @@ bool BitFsPyramidOscillation::validation()
 	if (!floorObject)
 		return false;
 
-	const BehaviorScript* pyramidBehavior = (const BehaviorScript*)(resource->addr("bhvBitfsTiltingInvertedPyramid"));
+	const BehaviorScript* pyramidBehavior = resource->getSymbol<const BehaviorScript>(GameSymbol::bhvBitfsTiltingInvertedPyramid);
 	if (floorObject->behavior != pyramidBehavior)
 		return false;
 
@@ -36,8 +36,8 @@ bool BitFsPyramidOscillation::validation()
 
 bool BitFsPyramidOscillation::execution()
 {
-	MarioState* marioState = *(MarioState**) (resource->addr("gMarioState"));
-	Camera* camera		   = *(Camera**) (resource->addr("gCamera"));
+	MarioState* marioState = *resource->getSymbol<MarioState*>(GameSymbol::gMarioState);
+	Camera* camera		   = *resource->getSymbol<Camera*>(GameSymbol::gCamera);
 	Object* pyramid		   = marioState->floor->object;
 
 	int16_t initAngle	 = -32768;
@@ -74,9 +74,9 @@ bool BitFsPyramidOscillation::execution()
 	// We want to turn uphill as late as possible, and also turn around as late
 	// as possible, without sacrificing XZ sum
 	uint64_t minFrame = initRunStatus.framePassedEquilibriumPoint == -1 ?
-		initRunStatus.m64Diff.frames.begin()->first :
+		initRunStatus.m64Diff.frames.First() :
 		initRunStatus.framePassedEquilibriumPoint;
-	uint64_t maxFrame = initRunStatus.m64Diff.frames.rbegin()->first;
+	uint64_t maxFrame = initRunStatus.m64Diff.frames.Last();
 	CustomStatus.finalXzSum[1] = initRunStatus.finalXzSum;
 	for (int i = 0; i < 15; i++)
 	{
@@ -111,7 +111,7 @@ bool BitFsPyramidOscillation::execution()
 			if (turnRunStatusBrake.asserted)
 			{
 				int64_t minFrame2 = turnRunStatusBrake.framePassedEquilibriumPoint;
-				int64_t maxFrame2 = turnRunStatusBrake.m64Diff.frames.rbegin()->first;
+				int64_t maxFrame2 = turnRunStatusBrake.m64Diff.frames.Last();
 				auto turnRunStatus2 = Execute<BitFsPyramidOscillation_Iteration>(oscillationParams, minFrame2, maxFrame2);
 
 				bool isFaster2 = turnRunStatus2.passedEquilibriumSpeed > turnRunStatus.passedEquilibriumSpeed;
@@ -150,7 +150,7 @@ bool BitFsPyramidOscillation::execution()
 			CustomStatus.maxPassedEquilibriumXzDist[i & 1] = turnRunStatus.passedEquilibriumXzDist;
 			Apply(turnRunStatus.m64Diff);
 			minFrame = turnRunStatus.framePassedEquilibriumPoint;
-			maxFrame = turnRunStatus.m64Diff.frames.rbegin()->first;
+			maxFrame = turnRunStatus.m64Diff.frames.Last();
 		}
 		else
 			break;
@@ -10,7 +10,7 @@
 bool BitFsPyramidOscillation_GetMinimumDownhillWalkingAngle::validation()
 {
 	// Check if Mario is on the pyramid platform
-	auto marioObj = (PyramidUpdateMem::Sm64Object*)(resource->addr("gMarioObject"));
+	auto marioObj = resource->getSymbol<PyramidUpdateMem::Sm64Object>(GameSymbol::gMarioObject);
 	return marioObj->platformIsPyramid;
 }
 
@@ -18,8 +18,8 @@ bool BitFsPyramidOscillation_GetMinimumDownhillWalkingAngle::execution()
 {
 	AdvanceFrameRead();
 
-	auto marioState = (PyramidUpdateMem::Sm64MarioState*)(resource->addr("gMarioStates"));
-	auto pyramid = (PyramidUpdateMem::Sm64Object*)(resource->addr("Pyramid"));
+	auto marioState = resource->getSymbol<PyramidUpdateMem::Sm64MarioState>(GameSymbol::gMarioStates);
+	auto pyramid = resource->getSymbol<PyramidUpdateMem::Sm64Object>(GameSymbol::Pyramid);
 	if (marioState->floorId == -1 || marioState->isFloorStatic)
 	{
 		CustomStatus.floorAngle = 0;
@@ -13,7 +13,7 @@
 bool BitFsPyramidOscillation_RunDownhill::validation()
 {
 	// Check if Mario is on the pyramid platform
-	MarioState* marioState = (MarioState*) (resource->addr("gMarioStates"));
+	MarioState* marioState = resource->getSymbol<MarioState>(GameSymbol::gMarioStates);
 
 	Surface* floor = marioState->floor;
 	if (!floor)
@@ -24,7 +24,7 @@ bool BitFsPyramidOscillation_RunDownhill::validation()
 		return false;
 
 	const BehaviorScript* pyramidBehavior =
-		(const BehaviorScript*) (resource->addr("bhvBitfsTiltingInvertedPyramid"));
+		resource->getSymbol<const BehaviorScript>(GameSymbol::bhvBitfsTiltingInvertedPyramid);
 	if (floorObject->behavior != pyramidBehavior)
 		return false;
 
@@ -40,9 +40,9 @@ bool BitFsPyramidOscillation_RunDownhill::validation()
 bool BitFsPyramidOscillation_RunDownhill::execution()
 {
 	const BehaviorScript* pyramidBehavior =
-		(const BehaviorScript*) (resource->addr("bhvBitfsTiltingInvertedPyramid"));
-	MarioState* marioState = (MarioState*) (resource->addr("gMarioStates"));
-	Camera* camera		   = *(Camera**) (resource->addr("gCamera"));
+		resource->getSymbol<const BehaviorScript>(GameSymbol::bhvBitfsTiltingInvertedPyramid);
+	MarioState* marioState = resource->getSymbol<MarioState>(GameSymbol::gMarioStates);
+	Camera* camera		   = *resource->getSymbol<Camera*>(GameSymbol::gCamera);
 	Object* pyramid		   = marioState->floor->object;
 
 	int targetXDirection =
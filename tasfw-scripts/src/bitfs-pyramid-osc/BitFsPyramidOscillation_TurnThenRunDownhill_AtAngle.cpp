@@ -29,7 +29,7 @@ bool BitFsPyramidOscillation_TurnThenRunDownhill_AtAngle::validation()
 	CustomStatus.angle = _angle;
 
 	// Verify Mario is running on the platform
-	MarioState* marioState = (MarioState*) (resource->addr("gMarioStates"));
+	MarioState* marioState = resource->getSymbol<MarioState>(GameSymbol::gMarioStates);
 
 	Surface* floor = marioState->floor;
 	if (!floor)
@@ -40,7 +40,7 @@ bool BitFsPyramidOscillation_TurnThenRunDownhill_AtAngle::validation()
 		return false;
 
 	const BehaviorScript* pyramidBehavior =
-		(const BehaviorScript*) (resource->addr("bhvBitfsTiltingInvertedPyramid"));
+		resource->getSymbol<const BehaviorScript>(GameSymbol::bhvBitfsTiltingInvertedPyramid);
 	if (floorObject->behavior != pyramidBehavior)
 		return false;
 
@@ -54,9 +54,9 @@ bool BitFsPyramidOscillation_TurnThenRunDownhill_AtAngle::validation()
 
 bool BitFsPyramidOscillation_TurnThenRunDownhill_AtAngle::execution()
 {
-	const BehaviorScript* pyramidBehavior = (const BehaviorScript*) (resource->addr("bhvBitfsTiltingInvertedPyramid"));
-	MarioState* marioState = (MarioState*) (resource->addr("gMarioStates"));
-	Camera* camera = *(Camera**)(resource->addr("gCamera"));
+	const BehaviorScript* pyramidBehavior = resource->getSymbol<const BehaviorScript>(GameSymbol::bhvBitfsTiltingInvertedPyramid);
+	MarioState* marioState = resource->getSymbol<MarioState>(GameSymbol::gMarioStates);
+	Camera* camera = *resource->getSymbol<Camera*>(GameSymbol::gCamera);
 
 	CustomStatus.initialXzSum = _oscillationParams.initialXzSum;
 	_oscillationParams.roughTargetAngle = marioState->faceAngle[1] + 0x8000;
@@ -3,7 +3,7 @@
 
 bool BitFsScApproach::validation()
 {
-	MarioState* marioState = (MarioState*)(resource->addr("gMarioStates"));
+	MarioState* marioState = resource->getSymbol<MarioState>(GameSymbol::gMarioStates);
 
 	// Calculate starting params
 	if (!_oscStatus.asserted || _oscStatus.oscillationMinMaxFrames.size() < 3)
@@ -51,7 +51,7 @@ bool BitFsScApproach::validation()
 		return false;
 
 	const BehaviorScript* pyramidBehavior =
-		(const BehaviorScript*)(resource->addr("bhvBitfsTiltingInvertedPyramid"));
+		resource->getSymbol<const BehaviorScript>(GameSymbol::bhvBitfsTiltingInvertedPyramid);
 	if (floorObject->behavior != pyramidBehavior)
 		return false;
 
@@ -60,7 +60,7 @@ bool BitFsScApproach::validation()
 
 bool BitFsScApproach::execution()
 {
-	MarioState* marioState = (MarioState*)(resource->addr("gMarioStates"));
+	MarioState* marioState = resource->getSymbol<MarioState>(GameSymbol::gMarioStates);
 
 	//First attempt with optimized equilibrium speed and increased xz sum
 	float prevMaxSpeed = _prevMaxSpeed;
@@ -94,7 +94,7 @@ bool BitFsScApproach::execution()
 
 			prevMaxSpeed = nextafterf(turnRunStatus.maxSpeed, INFINITY);
 
-			*customStatus = Modify<BitFsScApproach_AttemptDr_BF>(_roughTargetAngle, turnRunStatus.framePassedEquilibriumPoint, turnRunStatus.m64Diff.frames.rbegin()->first);
+			*customStatus = Modify<BitFsScApproach_AttemptDr_BF>(_roughTargetAngle, turnRunStatus.framePassedEquilibriumPoint, turnRunStatus.m64Diff.frames.Last());
 			return customStatus->drLanded;
 		},
 		[&](auto incumbent, auto challenger) //comparator
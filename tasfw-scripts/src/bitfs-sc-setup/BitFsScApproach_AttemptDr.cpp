@@ -12,7 +12,7 @@ public:
 
 bool BitFsScApproach_AttemptDr::validation()
 {
-	MarioState* marioState = (MarioState*)(resource->addr("gMarioStates"));
+	MarioState* marioState = resource->getSymbol<MarioState>(GameSymbol::gMarioStates);
 
 	//verify action
 	uint32_t action = marioState->action;
@@ -42,7 +42,7 @@ bool BitFsScApproach_AttemptDr::validation()
 	if (!floorObject)
 		return false;
 
-	const BehaviorScript* pyramidBehavior = (const BehaviorScript*)(resource->addr("bhvBitfsTiltingInvertedPyramid"));
+	const BehaviorScript* pyramidBehavior = resource->getSymbol<const BehaviorScript>(GameSymbol::bhvBitfsTiltingInvertedPyramid);
 	if (floorObject->behavior != pyramidBehavior)
 		return false;
 
@@ -51,8 +51,8 @@ bool BitFsScApproach_AttemptDr::validation()
 
 bool BitFsScApproach_AttemptDr::execution()
 {
-	MarioState* marioState = (MarioState*)(resource->addr("gMarioStates"));
-	Camera* camera = *(Camera**)(resource->addr("gCamera"));
+	MarioState* marioState = resource->getSymbol<MarioState>(GameSymbol::gMarioStates);
+	Camera* camera = *resource->getSymbol<Camera*>(GameSymbol::gCamera);
 	Object* pyramid = marioState->floor->object;
 
 	//attempt to dive straight forward
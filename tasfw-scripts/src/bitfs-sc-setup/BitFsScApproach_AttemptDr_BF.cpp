@@ -5,7 +5,7 @@
 
 bool BitFsScApproach_AttemptDr_BF::validation()
 {
-	MarioState* marioState = (MarioState*)(resource->addr("gMarioStates"));
+	MarioState* marioState = resource->getSymbol<MarioState>(GameSymbol::gMarioStates);
 		
 	// Check if Mario is on the pyramid platform
 	Surface* floor = marioState->floor;
@@ -17,7 +17,7 @@ bool BitFsScApproach_AttemptDr_BF::validation()
 		return false;
 
 	const BehaviorScript* pyramidBehavior =
-		(const BehaviorScript*)(resource->addr("bhvBitfsTiltingInvertedPyramid"));
+		resource->getSymbol<const BehaviorScript>(GameSymbol::bhvBitfsTiltingInvertedPyramid);
 	if (floorObject->behavior != pyramidBehavior)
 		return false;
 
@@ -26,8 +26,8 @@ bool BitFsScApproach_AttemptDr_BF::validation()
 
 bool BitFsScApproach_AttemptDr_BF::execution()
 {
-	MarioState* marioState = (MarioState*)(resource->addr("gMarioStates"));
-	Camera* camera = *(Camera**)(resource->addr("gCamera"));
+	MarioState* marioState = resource->getSymbol<MarioState>(GameSymbol::gMarioStates);
+	Camera* camera = *resource->getSymbol<Camera*>(GameSymbol::gCamera);
 	Object* pyramid = marioState->floor->object;
 
 	//advance 1 frame at a time along the previous path
@@ -46,8 +46,8 @@ bool BitFsScApproach_AttemptDr_BF::execution()
 	//Hack track platform x pos
 	/*
 	AdvanceFrameWrite(GetInputs(_minFrame - 1));
-	const BehaviorScript* trackPlatformBehavior = (const BehaviorScript*)(resource->addr("bhvPlatformOnTrack"));
-	Object* objectPool = (Object*)(resource->addr("gObjectPool"));
+	const BehaviorScript* trackPlatformBehavior = resource->getSymbol<const BehaviorScript>(GameSymbol::bhvPlatformOnTrack);
+	Object* objectPool = resource->getSymbol<Object>(GameSymbol::gObjectPool);
 	Object* trackPlatform = &objectPool[85];
 	if (trackPlatform->behavior != trackPlatformBehavior)
 		return false;
@@ -9,7 +9,7 @@
 bool GetMinimumDownhillWalkingAngle::validation()
 {
 	// Check if Mario is on the pyramid platform
-	MarioState* marioState = (MarioState*) (resource->addr("gMarioStates"));
+	MarioState* marioState = resource->getSymbol<MarioState>(GameSymbol::gMarioStates);
 
 	Surface* floor = marioState->floor;
 	if (!floor)
@@ -20,13 +20,13 @@ bool GetMinimumDownhillWalkingAngle::validation()
 		return false;
 
 	const BehaviorScript* pyramidBehavior =
-		(const BehaviorScript*) (resource->addr("bhvBitfsTiltingInvertedPyramid"));
+		resource->getSymbol<const BehaviorScript>(GameSymbol::bhvBitfsTiltingInvertedPyramid);
 	return floorObject->behavior == pyramidBehavior;
 }
 
 bool GetMinimumDownhillWalkingAngle::execution()
 {
-	MarioState* marioState = (MarioState*) (resource->addr("gMarioStates"));
+	MarioState* marioState = resource->getSymbol<MarioState>(GameSymbol::gMarioStates);
 	/*
 	s32(*mario_floor_is_slope)(struct MarioState*) = (s32(*)(struct
 	MarioState*))(resource->addr("mario_floor_is_slope"));
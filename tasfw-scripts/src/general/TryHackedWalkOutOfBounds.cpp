@@ -15,8 +15,8 @@ bool TryHackedWalkOutOfBounds::validation()
 
 bool TryHackedWalkOutOfBounds::execution()
 {
-	MarioState* marioState = (MarioState*) (resource->addr("gMarioStates"));
-	Camera* camera		   = *(Camera**) (resource->addr("gCamera"));
+	MarioState* marioState = resource->getSymbol<MarioState>(GameSymbol::gMarioStates);
+	Camera* camera		   = *resource->getSymbol<Camera*>(GameSymbol::gCamera);
 
 	CustomStatus.startSpeed = _speed;
 	Script::CopyVec3f(CustomStatus.startPos, marioState->pos);
@@ -0,0 +1,140 @@
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <sys/personality.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <tasfw/Script.hpp>
+#include <tasfw/resources/LibSm64.hpp>
+
+// States cached by one run must be loaded by the next. Each run is a separate
+// process, so the game is mapped anew, at the same address with ASLR off.
+// A run in between with the game mapped elsewhere must leave them alone.
+static constexpr int64_t targetFrame = 250;
+
+enum class CacheRunMode
+{
+	WRITE,
+	OTHER_ADDRESS,
+	READ,
+};
+
+static uint64_t HashSections(const LibSm64& resource)
+{
+	uint64_t hash = 0xcbf29ce484222325ull;
+	for (const SegVal& seg : resource.segment)
+		hash = PersistentSaveCache::HashBytes(seg.address, seg.length, hash);
+	return hash;
+}
+
+class CacheRun : public TopLevelScript<LibSm64>
+{
+public:
+	CacheRun(CacheRunMode mode, std::filesystem::path hashPath) : _mode(mode), _hashPath(std::move(hashPath)) {}
+
+	bool validation() { return true; }
+
+	bool execution()
+	{
+		LongLoad(targetFrame);
+		uint64_t hash = HashSections(*resource);
+
+		if (_mode == CacheRunMode::OTHER_ADDRESS)
+			return true;
+
+		if (_mode == CacheRunMode::WRITE)
+		{
+			if (resource->persistentCache->nWrites == 0)
+			{
+				printf("FAILED: first run wrote its LongLoad target to the cache\n");
+				return false;
+			}
+
+			std::ofstream(_hashPath) << hash;
+			return true;
+		}
+
+		uint64_t expected = 0;
+		std::ifstream(_hashPath) >> expected;
+		if (resource->persistentCache->nHits != 1 || resource->nResimulatedFrames != 0)
+		{
+			printf("FAILED: second run loaded its LongLoad target from the cache\n");
+			return false;
+		}
+		if (GetCurrentFrame() != targetFrame || hash != expected)
+		{
+			printf("FAILED: cached state matches the one that was written\n");
+			return false;
+		}
+
+		return true;
+	}
+
+	bool assertion() { return true; }
+
+private:
+	CacheRunMode _mode;
+	std::filesystem::path _hashPath;
+};
+
+static int RunCache(const char* dllPath, const std::filesystem::path& directory, CacheRunMode mode)
+{
+	LibSm64Config config;
+	config.dllPath = dllPath;
+	config.countryCode = CountryCode::SUPER_MARIO_64_J;
+	config.lightweight = false;
+	config.saveCacheDirectory = directory;
+
+	M64 m64;
+	std::mt19937 rng(1);
+	for (int64_t frame = 0; frame < 2 * targetFrame; frame++)
+		m64.frames.Set(frame, Inputs(rng(), rng(), rng()));
+
+	auto status = CacheRun::MainConfig<CacheRun>(m64, config, mode, directory / "expected-state");
+	return status.executed ? 0 : 1;
+}
+
+static bool RunChild(const char* dllPath, const std::filesystem::path& directory, const char* mode, bool randomize)
+{
+	pid_t pid = fork();
+	if (pid == 0)
+	{
+		// Applied by exec, so the run maps the game where this asks for
+		int persona = personality(0xffffffff);
+		personality(randomize ? persona & ~ADDR_NO_RANDOMIZE : persona | ADDR_NO_RANDOMIZE);
+		execl("/proc/self/exe", "test-persistent-cache", dllPath, directory.c_str(), mode, nullptr);
+		_exit(127);
+	}
+
+	int status = 0;
+	return pid > 0 && waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+// Usage: test-persistent-cache <libsm64> [<cache directory> write|other|read]
+int main(int argc, char** argv)
+{
+	if (argc == 4)
+	{
+		std::string mode = argv[3];
+		return RunCache(argv[1], argv[2], mode == "write" ? CacheRunMode::WRITE : mode == "other" ? CacheRunMode::OTHER_ADDRESS : CacheRunMode::READ);
+	}
+	if (argc != 2)
+	{
+		printf("Usage: %s <libsm64>\n", argv[0]);
+		return 1;
+	}
+
+	auto directory = std::filesystem::temp_directory_path() / ("tasfw-test-persistent-cache-" + std::to_string(getpid()));
+	std::filesystem::remove_all(directory);
+
+	bool passed = RunChild(argv[1], directory, "write", false)
+		&& RunChild(argv[1], directory, "other", true)
+		&& RunChild(argv[1], directory, "read", false);
+	std::filesystem::remove_all(directory);
+
+	if (passed)
+		printf("Persistent cache checks passed.\n");
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,126 @@
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <vector>
+#include <tasfw/Resource.hpp>
+#include <tasfw/SaveMemoryGovernor.hpp>
+
+// Slot tiers exercised through a resource whose whole state is a buffer
+// filled from the frame number, so every save can be checked on load.
+class BufferState
+{
+public:
+	std::vector<uint8_t> memory;
+};
+
+class BufferResource : public Resource<BufferState>
+{
+public:
+	static constexpr size_t stateSize = 64 * 1024;
+
+	std::vector<uint8_t> memory = std::vector<uint8_t>(stateSize);
+	uint32_t frame = 0;
+
+	void save(BufferState& state) const override { state.memory = memory; }
+
+	void load(const BufferState& state) override
+	{
+		memory = state.memory;
+		memcpy(&frame, memory.data(), sizeof(frame));
+	}
+
+	void advance() override
+	{
+		frame++;
+		for (size_t i = 0; i < memory.size(); i++)
+			memory[i] = uint8_t(frame * 31 + i);
+		memcpy(memory.data(), &frame, sizeof(frame));
+	}
+
+	void* addr(const char*) const override { return nullptr; }
+	std::size_t getStateSize(const BufferState& state) const override { return state.memory.capacity(); }
+	uint32_t getCurrentFrame() const override { return frame; }
+
+	bool serialize(const BufferState& state, std::vector<uint8_t>& out) const override
+	{
+		out.assign(state.memory.begin(), state.memory.end());
+		return true;
+	}
+
+	bool deserialize(std::span<const uint8_t> in, BufferState& state) const override
+	{
+		state.memory.assign(in.begin(), in.end());
+		return true;
+	}
+};
+
+static int nFailures = 0;
+
+static void check(bool condition, const char* what)
+{
+	if (!condition)
+	{
+		printf("FAILED: %s\n", what);
+		nFailures++;
+	}
+}
+
+// Without a compressed tier, evicted slots must spill to disk rather than be dropped
+static void testDiskTierOnly()
+{
+	BufferResource resource;
+	resource.slotManager._saveMemLimit = 4 * BufferResource::stateSize;
+	resource.slotManager.EnableDiskTier(std::filesystem::temp_directory_path(), 64 * BufferResource::stateSize);
+
+	std::vector<int64_t> slotIds;
+	for (int i = 0; i < 16; i++)
+	{
+		resource.FrameAdvance();
+		slotIds.push_back(resource.SaveState());
+	}
+
+	check(resource.slotManager.nEvictions > 0, "disk tier only: slots were evicted");
+	check(resource.slotManager.diskTier->GetStats().nInserts > 0, "disk tier only: evicted slots were spilled");
+
+	for (size_t i = 0; i < slotIds.size(); i++)
+	{
+		if (!resource.slotManager.isValid(slotIds[i]))
+		{
+			check(false, "disk tier only: spilled slot is still valid");
+			continue;
+		}
+
+		resource.LoadState(slotIds[i]);
+		BufferResource expected;
+		for (size_t frame = 0; frame <= i; frame++)
+			expected.advance();
+		check(resource.frame == i + 1 && resource.memory == expected.memory, "disk tier only: spilled slot loads back intact");
+	}
+}
+
+// A governed share covers the RAM and compressed tiers together, split as configured
+static void testGovernedTiers()
+{
+	SaveMemoryGovernor governor;
+	governor.SetBudget(int64_t(1) << 30);
+
+	BufferResource resource;
+	resource.slotManager._saveMemLimit = 2 * 1024 * 1024;
+	resource.slotManager.EnableCompressedTier(1024 * 1024);
+	resource.slotManager.SetMemoryGovernor(governor);
+
+	int64_t ramLimit = resource.slotManager._saveMemLimit;
+	int64_t compressedLimit = resource.slotManager.compressedTier->memLimit;
+	check(ramLimit + compressedLimit == resource.slotManager.memoryShare->limit.load(), "governed tiers: share covers both tiers");
+	check(compressedLimit > 0 && ramLimit / compressedLimit == 2, "governed tiers: configured split is kept");
+}
+
+int main()
+{
+	testDiskTierOnly();
+	testGovernedTiers();
+
+	if (nFailures == 0)
+		printf("All slot tier checks passed.\n");
+	return nFailures == 0 ? 0 : 1;
+}